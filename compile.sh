@@ -1,2 +1,35 @@
 eosio-cpp -o cronacle.wasm cronacle.cpp --abigen
 
+
+# database-operation tracing build (prints a DBTRACE line per action, not for production):
+# eosio-cpp -o cronacle_dbtrace.wasm cronacle.cpp --abigen -DCRONACLE_DBTRACE
+
+# native snapshot packer for the importstate action:
+# g++ -std=c++17 -O2 -o cronacle_snapshot tools/cronacle_snapshot.cpp
+
+# native exporter of a running contract's state, as a dump for the snapshot packer:
+# g++ -std=c++17 -O2 -o cronacle_export tools/cronacle_export.cpp
+
+# native Monte Carlo simulator for tuning the auction parameters:
+# g++ -std=c++17 -O2 -pthread -o cronacle_simulator tools/cronacle_simulator.cpp
+
+# native worst-case explorer, running the contract over the native host in tools/native
+# (add -fsanitize-coverage=trace-pc for --rank blocks):
+# g++ -std=c++17 -O2 -Wno-attributes -Itools/native -o cronacle_explorer tools/cronacle_explorer.cpp
+
+# native benchmark of the auctions table's writes with its current and its pre-0.14.0 indexes:
+# g++ -std=c++17 -O2 -Wno-attributes -Itools/native -o cronacle_bench tools/cronacle_bench.cpp
+
+# native table client (tools/cronacle_client.hpp) and its command line:
+# g++ -std=c++17 -O2 -o cronacle_query tools/cronacle_query.cpp
+
+# native columnar history store and query tool for settled auctions and bids:
+# g++ -std=c++17 -O3 -march=native -o cronacle_history tools/cronacle_history.cpp
+
+# tests of the native tools against an in-process stand-in node (tools/tests/standin_node.hpp):
+# g++ -std=c++17 -O2 -pthread -o test_client tools/tests/test_client.cpp && ./test_client
+# g++ -std=c++17 -O2 -pthread -o test_history tools/tests/test_history.cpp && ./test_history ./cronacle_history
+# g++ -std=c++17 -O2 -pthread -Wno-attributes -Itools/native -o test_snapshot tools/tests/test_snapshot.cpp && ./test_snapshot ./cronacle_export ./cronacle_snapshot
+
+# cost bounds of the contract's batched actions, replayed by the worst-case explorer (tools/tests/reproducers):
+# ./cronacle_explorer replay tools/tests/reproducers/maintain_index_bundles.txt --limit 500
@@ -2,19 +2,27 @@
 #include <eosio/system.hpp>
 #include <eosio/asset.hpp>
 #include <stdlib.h>
+#include <algorithm>
 
 #include "cronacle.hpp"
+#include "cronacle_context.hpp"
+#include "cronacle_rules.hpp"
 
 using namespace eosio;
 using namespace std;
 
-const std::string VERSION = "0.13.0";
+const std::string VERSION = "0.16.0";
 
 class [[eosio::contract("cronacle")]] cronacle : public eosio::contract {
 public:
 
   cronacle(name receiver, name code,  datastream<const char*> ds): contract(receiver, code, ds) {}
 
+#ifdef CRONACLE_DBTRACE
+  // print the database operations of the action
+  ~cronacle() { dbtrace_report(); }
+#endif
+
   /**
    * version action prints the version of the contract
    */
@@ -71,9 +79,10 @@ public:
  * reguser function is called by the credit function after notification of a transfer of FREEOS to the contract.
  * On receipt of credit, adds a new user to the users table and updates the system table with the new user count and CLS
  * 
+ * @param ctx the action context
  * @param user the account name of the user making the transfer of tokens
  */
-void reguser(name user) {
+void reguser(action_context &ctx, name user) {
 
   // is the user already registered?
   // find the account in the user table
@@ -85,24 +94,21 @@ void reguser(name user) {
 
   // it's a new user so add record to the users table
   users_table.emplace(get_self(), [&](auto &u) {  
-    u.time = current_time_point();  
+    u.time = ctx.now();  
     u.proton_account = user;
   });
 
   // update the system record - number of users and CLS
-  system_index system_table(get_self(), get_self().value);
-  auto system_iterator = system_table.begin();
-  if (system_iterator == system_table.end()) {
+  if (!ctx.has_system()) {
     // emplace
-    system_table.emplace(
-        get_self(), [&](auto &sys) {
-          sys.init = current_time_point();
-          sys.usercount = 1;
-          sys.cls = UCLS; // the CLS for the first verified user          
-        });
+    ctx.update_system([&](auto &sys) {
+      sys.init = ctx.now();
+      sys.usercount = 1;
+      sys.cls = UCLS; // the CLS for the first verified user          
+    });
   } else {
     // modify
-    system_table.modify(system_iterator, _self, [&](auto &sys) {
+    ctx.update_system([&](auto &sys) {
       sys.usercount += 1;
       sys.cls += UCLS; // add to the CLS for the verified user
     });
@@ -113,367 +119,1299 @@ void reguser(name user) {
 
 
 /**
- * withdraw action returns the user's available credit balance
+ * setprincipal action links the user's DFINITY principal to their proton account.
+ * Passing an empty principal clears the link.
  * 
- * @param user the user who is withdrawing credit
+ * @param user the registered user
+ * @param principal the user's DFINITY principal in text form
  */
 [[eosio::action]]
-void withdraw(name user) {
+void setprincipal(name user, string principal) {
 
   require_auth(user);
 
-  asset zero_amount = asset(0, get_currency().get_symbol());
+  users_index users_table(get_self(), user.value);
+  auto user_iterator = users_table.begin();
+  check(user_iterator != users_table.end(), "you must be registered in order to set a principal");
 
-  asset withdrawal_amount = get_available_credit(user);
+  link_principal(user, principal);
 
-  check(withdrawal_amount > zero_amount, "you do not have credit to withdraw");
+  users_table.modify(user_iterator, get_self(), [&](auto &u) {
+    u.dfinity_principal = principal;
+  });
+}
 
-  action transfer = action(
-      permission_level{get_self(), "active"_n},
-      name(CREDIT_CURRENCY_CONTRACT),
-      "transfer"_n,
-      std::make_tuple(get_self(), user, withdrawal_amount, std::string("withdraw auction credit")));
 
-    transfer.send();
+/**
+ * link_principal function replaces the user's entry in the principals lookup table. An empty principal
+ * removes the entry
+ * 
+ * @param user the user's account name
+ * @param principal the user's DFINITY principal in text form
+ */
+void link_principal(name user, const string &principal) {
+  check(principal.size() <= 63, "principal is too long");
 
-  // adjust the user's credit balance
-  credits_index credits_table(get_self(), user.value);
-  auto user_credit_iterator = credits_table.begin();
-  check(user_credit_iterator != credits_table.end(), "internal error, user's credit balance is undefined");
-  credits_table.modify(user_credit_iterator, get_self(), [&](auto &c) {
-      c.amount -= withdrawal_amount;
-  });
+  if (!principal.empty()) {
+    name linked_account = lookup_principal(principal);
+    check(linked_account == name() || linked_account == user, "principal is linked to another account");
+  }
+
+  principals_index principals_table(get_self(), get_self().value);
+  auto principal_iterator = principals_table.find(user.value);
 
+  if (principal.empty()) {
+    if (principal_iterator != principals_table.end()) {
+      principals_table.erase(principal_iterator);
+    }
+  } else if (principal_iterator == principals_table.end()) {
+    principals_table.emplace(get_self(), [&](auto &p) {
+      p.account = user;
+      p.principal = principal;
+      p.hash = principal_hash(principal);
+    });
+  } else {
+    principals_table.modify(principal_iterator, get_self(), [&](auto &p) {
+      p.principal = principal;
+      p.hash = principal_hash(principal);
+    });
+  }
 }
 
 
 /**
- * If the user sends a token other than FREEOS to the contract, the contract will reject the
- * transaction
+ * getaccount action returns the proton account linked to a DFINITY principal
  * 
- * @param user the account that sent the token
- * @param to The account that is receiving the tokens
- * @param quantity The amount of the asset being transferred.
- * @param memo The memo field is a string that is sent along with the transfer. It is not used by the
- * contract, but it is available for the user to send information to the contract.
+ * @param principal the DFINITY principal in text form
+ * 
+ * @return The linked proton account
  */
-[[eosio::on_notify("xtokens::transfer")]]
-void refusefoobar(name user, name to, asset quantity, std::string memo) {
-  if (to == get_self()) {
-    check(false, "The auction accepts FREEOS as credit");
-  }
-  
+[[eosio::action]]
+name getaccount(string principal) {
+  name account = lookup_principal(principal);
+  check(account != name(), "principal is not linked to an account");
+
+  return account;
 }
 
 
 /**
- * credit is a notification function that adds the amount of credit received to the user's credit balance
- * It checks that the token is FREEOS and throws an assert error if not.
- * On success it updates the user's credit in the credits table.
+ * lookup_principal function finds the account linked to a principal using the byhash index
  * 
- * @param user the account that sent the tokens
- * @param to The account that is receiving the credit
- * @param quantity The amount of credit being transferred.
- * @param memo The memo is a string that is passed along with the transfer. It is not used in this
- * contract, but it is a good idea to include it in your contract.
+ * @param principal the DFINITY principal in text form
  * 
- * @return Nothing is being returned.
+ * @return The linked account, or an empty name if the principal is not linked
  */
-[[eosio::on_notify("*::transfer")]]
-void credit(name user, name to, asset quantity, std::string memo) {
-  if (user == get_self()) {
-      return;
+name lookup_principal(const string &principal) {
+  principals_index principals_table(get_self(), get_self().value);
+  auto hash_idx = principals_table.get_index<"byhash"_n>();
+  uint64_t hash = principal_hash(principal);
+
+  // entries with the same hash are adjacent in the index
+  for (auto hash_itr = hash_idx.lower_bound(hash); hash_itr != hash_idx.end() && hash_itr->hash == hash; hash_itr++) {
+    if (hash_itr->principal == principal) {
+      return hash_itr->account;
     }
+  }
 
-  // check the symbol
-  extended_symbol currency = get_currency();
-  symbol currency_symbol = currency.get_symbol();
-  check(quantity.symbol == currency_symbol, "You must credit your account with " + currency_symbol.code().to_string());
-  check(currency.get_contract() == get_first_receiver(), "source of token is not valid");
+  return name();
+}
 
-  check(to == get_self(), "recipient of credit is incorrect");
 
-  // upsert the user's credit record
-  credits_index credits_table(get_self(), user.value);
-  auto credits_iterator = credits_table.begin();
+/**
+ * principal_hash function returns the first 64 bits of the sha256 hash of a principal
+ * 
+ * @param principal the DFINITY principal in text form
+ */
+uint64_t principal_hash(const string &principal) {
+  auto digest = sha256(principal.data(), principal.size()).extract_as_byte_array();
 
-  if (credits_iterator == credits_table.end()) {
-    // emplace
-    credits_table.emplace(get_self(), [&](auto &c) {
-          c.amount = quantity;        
-    });
+  uint64_t hash = 0;
+  for (int i = 0; i < 8; i++) {
+    hash = (hash << 8) | digest[i];
+  }
 
-    // add user to the users table (auto-registration)
-    reguser(user);
+  return hash;
+}
 
-  } else {
-    // modify
-    credits_table.modify(credits_iterator, _self, [&](auto &c) {
-      c.amount += quantity;
-    });
-  }
 
+/**
+ * withdraw action returns the user's available credit balance
+ * 
+ * @param user the user who is withdrawing credit
+ */
+[[eosio::action]]
+void withdraw(name user) {
+
+  require_auth(user);
+
+  action_context ctx(get_self());
+
+  touch(ctx, user);
+
+  asset withdrawal_amount = get_available_credit(ctx, user);
+
+  check(withdrawal_amount > ctx.zero(), "you do not have credit to withdraw");
+
+  pay_withdrawal(ctx, user, withdrawal_amount, "withdraw auction credit");
+
+  ctx.flush();
 }
 
 
 /**
- * create_auction function creates a new auction record for the NFT with the specified ID
- * The auction record contains the auction start, end and end-of-bidding times.
- * This function is called by the bid action, i.e. the system responds to user activity
+ * subwithdraw action withdraws the available balances of a custodian's sub-accounts in one transfer to the
+ * custodian, who settles with the sub-accounts' owners. Emptied sub-accounts are deleted
  * 
- * @param nft_id The ID of the NFT to be auctioned.
+ * @param custodian the custodian's account name
+ * @param sub_ids the ids of the sub-accounts, at most MAX_SUBACCOUNT_BATCH
  */
-void create_auction(uint64_t nft_id) {
+[[eosio::action]]
+void subwithdraw(name custodian, vector<uint64_t> sub_ids) {
 
-  // get the auction length and bidding period length
-  parameters_index parameters_table(get_self(), get_self().value);
-  auto parameter_iterator = parameters_table.find(name("auctperiod").value);
-  check(parameter_iterator != parameters_table.end(), "auction period is undefined");
-  const uint32_t AUCTION_LENGTH_SECONDS = stoi(parameter_iterator->value);
+  require_auth(custodian);
 
-  parameter_iterator = parameters_table.find(name("bidperiod").value);
-  check(parameter_iterator != parameters_table.end(), "bidding period is undefined");
-  const uint32_t AUCTION_BIDDING_PERIOD_SECONDS = stoi(parameter_iterator->value);
+  check(!sub_ids.empty() && sub_ids.size() <= MAX_SUBACCOUNT_BATCH, "between 1 and " + to_string(MAX_SUBACCOUNT_BATCH) + " sub-accounts may be withdrawn at once");
 
-  // work out the start time from the system init time
-  system_index system_table(get_self(), get_self().value);
-  auto system_iterator = system_table.begin();
-  check(system_iterator != system_table.end(), "the system record is undefined");
+  action_context ctx(get_self());
 
-  time_point init = system_iterator->init;
+  touch(ctx, custodian);
 
-  uint64_t init_secs = init.sec_since_epoch();
-  uint64_t now_secs = current_time_point().sec_since_epoch();
+  custodians_index custodians_table(get_self(), get_self().value);
+  auto custodian_iterator = custodians_table.find(custodian.value);
+  check(custodian_iterator != custodians_table.end(), "you do not have sub-accounts");
 
-  // if we are in the cooldown period then abandon attempt to start a new auction
-  uint64_t elapsed_secs = ((now_secs - init_secs) % AUCTION_LENGTH_SECONDS);
-  check(elapsed_secs <= AUCTION_BIDDING_PERIOD_SECONDS, "bidding is not permitted outside of the bidding period");
+  subaccounts_index subaccounts_table(get_self(), custodian.value);
+  asset withdrawal_amount = ctx.zero();
 
-  uint64_t start_secs = now_secs - elapsed_secs;
-  uint64_t bidding_end_secs = start_secs + AUCTION_BIDDING_PERIOD_SECONDS;
-  uint64_t end_secs = start_secs + AUCTION_LENGTH_SECONDS;
+  for (uint64_t sub_id : sub_ids) {
+    auto sub_iterator = subaccounts_table.find(sub_id);
+    check(sub_iterator != subaccounts_table.end(), "sub-account " + to_string(sub_id) + " has no balance");
 
-  time_point start = time_point(seconds(start_secs));
-  time_point bidding_end = time_point(seconds(bidding_end_secs));
-  time_point end = time_point(milliseconds((end_secs * 1000) - 1)); // 1 millisecond before possible next auction
+    asset available = get_subaccount_available(ctx, *custodian_iterator, *sub_iterator);
+    if (available.amount == 0) continue;
 
-  // calculate the number of the auction
-  uint32_t last_number = 0;
-  auctions_index auctions_table(get_self(), get_self().value);
-  auto auction_iterator = auctions_table.rbegin();
-  if (auction_iterator != auctions_table.rend()) {
-    last_number = auction_iterator->number;
+    withdrawal_amount += available;
+    if (available == sub_iterator->amount) {
+      subaccounts_table.erase(sub_iterator);
+    } else {
+      subaccounts_table.modify(sub_iterator, get_self(), [&](auto &sa) {
+        sa.amount -= available;
+      });
+    }
   }
-  uint32_t next_number = last_number + 1;
 
-  // write the record
-  auctions_table.emplace(get_self(), [&](auto &a) {
-    a.number = next_number;
-    a.nftid = nft_id;
-    a.start = start;
-    a.bidding_end = bidding_end;
-    a.end = end;
+  check(withdrawal_amount > ctx.zero(), "the sub-accounts do not have credit to withdraw");
+
+  custodians_table.modify(custodian_iterator, get_self(), [&](auto &c) {
+    c.held -= withdrawal_amount;
   });
 
-}
+  pay_withdrawal(ctx, custodian, withdrawal_amount, "withdraw sub-account credit");
 
+  ctx.flush();
+}
 
 
 /**
- * add_bid function is called by the bid action. It adds a bid to the bids table, but only if the bid is higher
- * than the current highest bid
+ * pay_withdrawal function debits a withdrawal from the user's credit and transfers it, or queues it for the
+ * payout action if the payoutqueue parameter is switched on
  * 
- * @param user the user who is placing the bid
- * @param nft_id the id of the NFT that is being bid on
- * @param bidamount the amount of the bid
+ * @param ctx the action context
+ * @param user the user who is withdrawing credit
+ * @param withdrawal_amount the amount withdrawn
+ * @param memo the transfer memo
  */
-void add_bid(name user, uint64_t nft_id, asset bidamount) {
-
-  bids_index bids_table(get_self(), get_self().value);
-  // count the number of bids
-  uint8_t bids_count = 0;
-  auto bids_itr = bids_table.begin();
-  while (bids_itr != bids_table.end()) {
-    bids_count++;
-    bids_itr++;
+void pay_withdrawal(action_context &ctx, name user, asset withdrawal_amount, string memo) {
+
+  if (ctx.enabled(name("payoutqueue"))) {
+    // queue the withdrawal for the payout action, merging with any payout already pending for the user
+    auto payout_iterator = ctx.payouts_table.find(user.value);
+    if (payout_iterator == ctx.payouts_table.end()) {
+      ctx.payouts_table.emplace(get_self(), [&](auto &p) {
+        p.user = user;
+        p.amount = withdrawal_amount;
+        p.requested = ctx.now();
+      });
+    } else {
+      ctx.payouts_table.modify(payout_iterator, get_self(), [&](auto &p) {
+        p.amount += withdrawal_amount;
+      });
+    }
+    ctx.adjust_totals(ctx.zero(), withdrawal_amount);
+  } else {
+    send_credit(user, withdrawal_amount, memo);
   }
 
-  // find the winning bid
-  auto amt_idx = bids_table.get_index<"byamount"_n>();
-  auto amt_itr = amt_idx.rbegin();
+  // adjust the user's credit balance. A queued withdrawal is debited now so that it cannot be bid or withdrawn again
+  check(ctx.has_credit_record(user), "internal error, user's credit balance is undefined");
+  ctx.set_credit(user, ctx.credit(user) - withdrawal_amount);
+}
 
-  asset bid_to_beat = asset(0, get_currency().get_symbol()); // initialise to zero bid
-  if (amt_itr != amt_idx.rend()) {
-    bid_to_beat = amt_itr->bidamount;
-  }
 
-  /* debugging code: 
+/**
+ * payout action transfers queued withdrawals to their users. Each user has at most one pending payout, so
+ * repeated withdrawals are paid with a single transfer. Anyone may call the action.
+ * 
+ * @param max the maximum number of payouts to process
+ */
+[[eosio::action]]
+void payout(uint32_t max) {
 
-  const string bidstr = bidamount.to_string();
-  const string incrstr = smallest_increment.to_string();
-  const string bidtobeatstr = bid_to_beat.to_string();
-  const string diffstr = (bidamount - bid_to_beat).to_string();
-  string result = "";
-  if ((bidamount - bid_to_beat) >= smallest_increment) {
-    result = "success";
-  } else {
-    result = "fail";
+  check(max > 0, "max must be greater than zero");
+
+  action_context ctx(get_self());
+  payouts_index &payouts_table = ctx.payouts_table;
+  auto payout_iterator = payouts_table.begin();
+  check(payout_iterator != payouts_table.end(), "there are no pending payouts");
+
+  uint32_t processed = 0;
+  while (payout_iterator != payouts_table.end() && processed < max) {
+    send_credit(payout_iterator->user, payout_iterator->amount, "withdraw auction credit");
+    ctx.adjust_totals(ctx.zero(), -payout_iterator->amount);
+    payout_iterator = payouts_table.erase(payout_iterator);
+    processed++;
   }
-  const string debugstr = "bid: " + bidstr + " increment: "
-   + incrstr + " bid to beat: " + bidtobeatstr + " difference: " + diffstr
-   + " result: " + result;
 
-  check(false, debugstr);
+  ctx.flush();
+}
 
-  end of debugging code */
 
-  extended_symbol currency = get_currency();
-  int currency_multiplier = intPower(10, currency.get_symbol().precision());
+/**
+ * balances action reports the credit of a list of users, with the totals of all credit and queued payouts.
+ * The totals count only tracked credit: on a contract upgraded from a version before the holders and totals
+ * tables, they are partial until maintain("track credit") has been run for every user who held credit before
+ * the upgrade
+ * 
+ * @param accounts the users, at most MAX_BALANCE_ROWS
+ * 
+ * @return The users' balances and the totals
+ */
+[[eosio::action]]
+balance_report balances(vector<name> accounts) {
 
-  // get the minimum bid increment parameter
-  name minimumbid = name("minimumbid");
-  parameters_index parameters_table(get_self(), get_self().value);
-  auto minbid_itr = parameters_table.find(minimumbid.value);
-  check(minbid_itr != parameters_table.end(), "minimumbid parameter is not defined");
-  asset MINIMUM_BID_INCREMENT = asset(stoi(minbid_itr->value) * currency_multiplier, currency.get_symbol());
+  check(accounts.size() <= MAX_BALANCE_ROWS, "at most " + to_string(MAX_BALANCE_ROWS) + " accounts may be reported at once");
 
-  // get the bidstep parameter
-  name bidstep = name("bidstep");
-  auto bidstep_itr = parameters_table.find(bidstep.value);
-  check(bidstep_itr != parameters_table.end(), "bidstep parameter is not defined");
-  asset BIDSTEP_INCREMENT = asset(stoi(bidstep_itr->value) * currency_multiplier, currency.get_symbol());
-
-  asset minimum_next_bid;
-  if (bid_to_beat.amount == 0) {
-    minimum_next_bid = MINIMUM_BID_INCREMENT;
-  } else {
-    minimum_next_bid = bid_to_beat + BIDSTEP_INCREMENT;
+  action_context ctx(get_self());
+  balance_report report = start_report(ctx);
+  userbid winning_bid = top_bid(ctx);
+
+  for (name account : accounts) {
+    report.balances.push_back(balance_of(ctx, account, winning_bid));
   }
-  
-  const string bid_amount_msg = "the highest bid is currently " + bid_to_beat.to_string() + ". you must bid at least " + minimum_next_bid.to_string();
-  check(bidamount >= minimum_next_bid, bid_amount_msg);
 
-  // check if we are replacing a previous bid by the same user
-  auto userbid_itr = bids_table.find(user.value);
-  if (userbid_itr != bids_table.end()) {
-    // modify user's bid
-    bids_table.modify(userbid_itr, get_self(), [&](auto &b) {
-      b.bidamount = bidamount;
-    });
-  } else {
-    // at this point we are adding a top bid that from a user who has not bid before
-    // drop the lowest bid from the bids table (if necessary) and emplace the new bid
+  return report;
+}
 
-    // TODO: if there are 3 bids then erase the lowest one
-    if (bids_count == 3) {
-      auto lowest_bid_itr = amt_idx.begin();
-      amt_idx.erase(lowest_bid_itr);
-    }
 
-    // add new top bid
-    bids_table.emplace(
-      get_self(), [&](auto &b) {
-        b.bidtime = current_time_point();
-        b.bidder = user;
-        b.bidamount = bidamount;
-        b.nftid = nft_id;        
-      });
+/**
+ * allbalances action reports the credit of every user who has a credit record, one page at a time, in account
+ * name order, with the totals of all credit and queued payouts. Only users whose credit is tracked are listed,
+ * and the totals are partial in the same way as those of balances until maintain("track credit") has been run
+ * for every user who held credit before the upgrade
+ * 
+ * @param cursor the first account of the page, an empty name for the first page
+ * @param limit the number of accounts in the page, at most MAX_BALANCE_ROWS
+ * 
+ * @return The users' balances, the totals and the cursor of the next page
+ */
+[[eosio::action]]
+balance_report allbalances(name cursor, uint32_t limit) {
+
+  check(limit > 0 && limit <= MAX_BALANCE_ROWS, "limit must be between 1 and " + to_string(MAX_BALANCE_ROWS));
 
+  action_context ctx(get_self());
+  balance_report report = start_report(ctx);
+  userbid winning_bid = top_bid(ctx);
+
+  auto holder_iterator = ctx.holders_table.lower_bound(cursor.value);
+  while (holder_iterator != ctx.holders_table.end() && report.balances.size() < limit) {
+    report.balances.push_back(balance_of(ctx, holder_iterator->account, winning_bid));
+    holder_iterator++;
   }
+
+  report.next = (holder_iterator != ctx.holders_table.end()) ? holder_iterator->account : name();
+
+  return report;
 }
 
 
 /**
- * get_available_credit function returns the user's total credit minus the amount of the user's winning bid.
- * Called by the bid and withdraw actions.
- * 
- * @param user the user's account name
+ * start_report function returns a balance report holding the totals of all credit and queued payouts
  * 
- * @return The user's available credit, i.e. number of tokens deposited.
+ * @param ctx the action context
  */
-asset get_available_credit(name user) {
-  // default values
-  asset zero_credit = asset(0, get_currency().get_symbol());
-  asset user_total_credit = zero_credit;
-  asset winning_bid_amount = zero_credit;
-
-  // get the user's credit
-  credits_index credit_table(get_self(), user.value);
-  auto credit_iterator = credit_table.begin();
-  if (credit_iterator == credit_table.end()) {  // no credit record
-    user_total_credit = zero_credit;
-  } else {
-    user_total_credit = credit_iterator->amount;
+balance_report start_report(action_context &ctx) {
+  balance_report report;
+  report.total_credit = ctx.zero();
+  report.total_queued = ctx.zero();
+
+  auto totals_iterator = ctx.totals_table.begin();
+  if (totals_iterator != ctx.totals_table.end()) {
+    report.total_credit = totals_iterator->credit;
+    report.total_queued = totals_iterator->queued;
   }
 
-  // get the winning bid amount
-  bids_index bids_table(get_self(), get_self().value);
-  auto amt_idx = bids_table.get_index<"byamount"_n>();
+  return report;
+}
+
+
+/**
+ * top_bid function returns the winning bid of the current auction, or an empty bid if there is none
+ * 
+ * @param ctx the action context
+ */
+userbid top_bid(action_context &ctx) {
+  auto amt_idx = ctx.bids_table.get_index<"byamount"_n>();
   auto bid_itr = amt_idx.rbegin();
-  if (bid_itr != amt_idx.rend()) {
-    if (bid_itr->bidder == user) {
-      winning_bid_amount = bid_itr->bidamount;
-    }
-  }
 
-  return user_total_credit - winning_bid_amount;  
+  return (bid_itr != amt_idx.rend()) ? *bid_itr : userbid{};
 }
 
 
 /**
+ * balance_of function returns a user's credit, the part of it locked in the winning bid, the part held for
+ * the user's sub-accounts and the user's queued payout. The available credit matches get_available_credit
  * 
- * close_auction function is called to clean up after an auction has ended.
- * 
- * It finds the winning bid, transfers the NFT to the winner, reduces the winner's credit by the bid
- * amount, records the winner and winning bid in the latest auction record, clears the bids table, and
- * deletes the NFT record
- * 
- * @param nft_id the id of the nft being auctioned
+ * @param ctx the action context
+ * @param account the user's account name
+ * @param winning_bid the winning bid of the current auction
  */
-void close_auction(uint64_t nft_id) {
+account_balance balance_of(action_context &ctx, name account, const userbid &winning_bid) {
+  account_balance balance;
+  balance.account = account;
+  balance.credit = ctx.credit(account);
+  balance.locked = ctx.zero();
+  balance.held = ctx.zero();
+  balance.queued = ctx.zero();
+
+  if (winning_bid.bidder != name() && account == winning_bid.bidder) {
+    balance.locked = winning_bid.bidamount;
+  }
+  balance.available = balance.credit - balance.locked;
+
+  // a custodian's sub-account balances are not available to it, and a winning bid placed for a sub-account
+  // is locked in the sub-account's balance
+  custodians_index custodians_table(get_self(), get_self().value);
+  auto custodian_iterator = custodians_table.find(account.value);
+  if (custodian_iterator != custodians_table.end()) {
+    balance.held = custodian_iterator->held;
+    balance.available -= balance.held;
+    if (balance.locked.amount > 0 && custodian_iterator->bid_for_subaccount(winning_bid)) {
+      balance.available += balance.locked;
+    }
+  }
 
-  // find the winning bid
-  bids_index bids_table(get_self(), get_self().value);
-  auto amt_idx = bids_table.get_index<"byamount"_n>();
-  auto bid_itr = amt_idx.rbegin();
-  check(bid_itr != amt_idx.rend(), "there is no winning bid");
+  auto payout_iterator = ctx.payouts_table.find(account.value);
+  if (payout_iterator != ctx.payouts_table.end()) {
+    balance.queued = payout_iterator->amount;
+  }
 
-  name winner = bid_itr->bidder;
-  asset bidamount = bid_itr->bidamount;
+  return balance;
+}
 
-  // transfer nft to the winner
-  vector <uint64_t> nftids;
-  nftids.push_back(nft_id);
-  string memo = "winner of auction for nft " + to_string(nft_id);
 
+/**
+ * send_credit function transfers credit tokens from the contract to a user
+ * 
+ * @param to the account receiving the tokens
+ * @param quantity the amount to transfer
+ * @param memo the transfer memo
+ */
+void send_credit(name to, asset quantity, string memo) {
   action transfer = action(
       permission_level{get_self(), "active"_n},
-      nft_account,
+      name(CREDIT_CURRENCY_CONTRACT),
       "transfer"_n,
-      std::make_tuple(get_self(), winner, nftids, memo));
+      std::make_tuple(get_self(), to, quantity, memo));
 
     transfer.send();
+}
 
-  // reduce the winner's credit by the bid amount
-  credits_index credit_table(get_self(), winner.value);
-  auto credit_iterator = credit_table.begin();
-  check(credit_iterator != credit_table.end(), "winning bidder does not have a credit record");
-  check(credit_iterator->amount >= bidamount, "winning bidder does not have sufficient credit");
-  credit_table.modify(credit_iterator, get_self(), [&](auto &c) {
-      c.amount -= bidamount;
-    });
-
-  // record the winner and winning bid in the latest auction record
-  auctions_index auctions_table(get_self(), get_self().value);
-  auto auction_iterator = auctions_table.rbegin();
-  check(auction_iterator != auctions_table.rend(), "auction record is undefined");
-  auto latest_auction_iterator = auction_iterator.base();
-  latest_auction_iterator--;
 
-  auctions_table.modify(latest_auction_iterator, get_self(), [&](auto &a) {
-    a.winner = winner;
-    a.bidamount = bidamount;
+/**
+ * If the user sends a token other than FREEOS to the contract, the contract will reject the
+ * transaction
+ * 
+ * @param user the account that sent the token
+ * @param to The account that is receiving the tokens
+ * @param quantity The amount of the asset being transferred.
+ * @param memo The memo field is a string that is sent along with the transfer. It is not used by the
+ * contract, but it is available for the user to send information to the contract.
+ */
+[[eosio::on_notify("xtokens::transfer")]]
+void refusefoobar(name user, name to, asset quantity, std::string memo) {
+  if (to == get_self()) {
+    check(false, "The auction accepts FREEOS as credit");
+  }
+  
+}
+
+
+/**
+ * credit is a notification function that adds the amount of credit received to the user's credit balance
+ * It checks that the token is FREEOS and throws an assert error if not.
+ * On success it updates the user's credit in the credits table.
+ * 
+ * @param user the account that sent the tokens
+ * @param to The account that is receiving the credit
+ * @param quantity The amount of credit being transferred.
+ * @param memo The memo is a string that is passed along with the transfer. It is not used in this
+ * contract, but it is a good idea to include it in your contract.
+ * 
+ * @return Nothing is being returned.
+ */
+[[eosio::on_notify("*::transfer")]]
+void credit(name user, name to, asset quantity, std::string memo) {
+  if (user == get_self()) {
+      return;
+    }
+
+  action_context ctx(get_self());
+
+  // check the symbol
+  extended_symbol currency = ctx.currency();
+  symbol currency_symbol = currency.get_symbol();
+  check(quantity.symbol == currency_symbol, "You must credit your account with " + currency_symbol.code().to_string());
+  check(currency.get_contract() == get_first_receiver(), "source of token is not valid");
+
+  check(to == get_self(), "recipient of credit is incorrect");
+
+  // upsert the user's credit record
+  if (!ctx.has_credit_record(user)) {
+    // emplace
+    ctx.set_credit(user, quantity);
+
+    // add user to the users table (auto-registration)
+    reguser(ctx, user);
+
+  } else {
+    // modify
+    ctx.set_credit(user, ctx.credit(user) + quantity);
+  }
+
+  // a deposit with a sub:<id> memo is held for one of the sender's sub-accounts
+  if (memo.compare(0, SUBACCOUNT_MEMO_PREFIX.size(), SUBACCOUNT_MEMO_PREFIX) == 0) {
+    credit_subaccount(user, parse_subaccount_id(memo), quantity);
+  }
+
+  touch(ctx, user);
+
+  ctx.flush();
+}
+
+
+/**
+ * parse_subaccount_id function returns the sub-account id of a sub:<id> memo. The id is a nonzero decimal number
+ * 
+ * @param memo the transfer memo
+ */
+uint64_t parse_subaccount_id(const string &memo) {
+  const char *invalid_msg = "the memo must be sub:<id>, where the id is a nonzero number";
+
+  string digits = memo.substr(SUBACCOUNT_MEMO_PREFIX.size());
+  check(!digits.empty() && digits.size() <= 20, invalid_msg);
+
+  uint64_t id = 0;
+  for (char digit : digits) {
+    check(digit >= '0' && digit <= '9', invalid_msg);
+    uint64_t value = digit - '0';
+    check(id <= (UINT64_MAX - value) / 10, invalid_msg);
+    id = id * 10 + value;
+  }
+  check(id != 0, invalid_msg);
+
+  return id;
+}
+
+
+/**
+ * credit_subaccount function adds a deposit to a custodian's sub-account, creating the sub-account and the
+ * custodian record if necessary. The deposit has already been added to the custodian's credit
+ * 
+ * @param custodian the account that sent the tokens
+ * @param sub_id the id of the sub-account
+ * @param quantity the amount deposited
+ */
+void credit_subaccount(name custodian, uint64_t sub_id, asset quantity) {
+
+  subaccounts_index subaccounts_table(get_self(), custodian.value);
+  auto sub_iterator = subaccounts_table.find(sub_id);
+  if (sub_iterator == subaccounts_table.end()) {
+    subaccounts_table.emplace(get_self(), [&](auto &sa) {
+      sa.id = sub_id;
+      sa.amount = quantity;
+    });
+  } else {
+    subaccounts_table.modify(sub_iterator, get_self(), [&](auto &sa) {
+      sa.amount += quantity;
+    });
+  }
+
+  custodians_index custodians_table(get_self(), get_self().value);
+  auto custodian_iterator = custodians_table.find(custodian.value);
+  if (custodian_iterator == custodians_table.end()) {
+    custodians_table.emplace(get_self(), [&](auto &c) {
+      c.account = custodian;
+      c.held = quantity;
+      c.bid_subaccount = 0;
+      c.bid_nftid = 0;
+      c.bid_amount = asset(0, quantity.symbol);
+    });
+  } else {
+    custodians_table.modify(custodian_iterator, get_self(), [&](auto &c) {
+      c.held += quantity;
+    });
+  }
+}
+
+
+/**
+ * touch function records the time of the user's latest deposit, bid or withdrawal
+ * 
+ * @param ctx the action context
+ * @param user the user's account name
+ */
+void touch(action_context &ctx, name user) {
+  touch(ctx, user, ctx.now());
+}
+
+
+/**
+ * touch function records the given time as the time of the user's latest activity
+ * 
+ * @param ctx the action context
+ * @param user the user's account name
+ * @param time the time of the activity
+ */
+void touch(action_context &ctx, name user, time_point time) {
+  auto activity_iterator = ctx.activity_table.find(user.value);
+
+  if (activity_iterator == ctx.activity_table.end()) {
+    ctx.activity_table.emplace(get_self(), [&](auto &a) {
+      a.account = user;
+      a.last = time;
+    });
+  } else {
+    ctx.activity_table.modify(activity_iterator, get_self(), [&](auto &a) {
+      a.last = time;
+    });
+  }
+}
+
+
+/**
+ * gc action removes the records of idle users who have no credit and no bid, oldest activity first,
+ * and returns the approximate number of bytes of RAM reclaimed
+ * 
+ * @pre requires authority of the contract or an account listed in the admins table
+ * 
+ * @param user the account that is calling the action
+ * @param max_rows the maximum number of activity records to examine
+ * @param min_idle the number of seconds since a user's last activity before the user can be removed
+ * 
+ * @return The approximate number of bytes of RAM reclaimed
+ */
+[[eosio::action]]
+uint64_t gc(name user, uint32_t max_rows, uint32_t min_idle) {
+
+  require_auth(user);
+
+  if (!isadmin(user)) {
+    check(user == get_self(), "action requires authority of the contract or an account listed in the admins table");
+  }
+
+  action_context ctx(get_self());
+
+  uint64_t idle_before = (ctx.now() - seconds(min_idle)).time_since_epoch().count();
+  uint64_t reclaimed_bytes = 0;
+
+  auto idle_idx = ctx.activity_table.get_index<"byidle"_n>();
+  auto idle_itr = idle_idx.begin();
+
+  uint32_t examined = 0;
+  while (idle_itr != idle_idx.end() && idle_itr->get_secondary() < idle_before && examined < max_rows) {
+    name account = idle_itr->account;
+    examined++;
+
+    // the account must not have a bid on the current auction
+    if (ctx.bids_table.find(account.value) != ctx.bids_table.end()) {
+      idle_itr++;
+      continue;
+    }
+
+    // an account that holds credit is not collectable until the credit is withdrawn, which records new activity
+    bool collectable = (ctx.credit(account).amount == 0);
+
+    reclaimed_bytes += ROW_OVERHEAD_BYTES + pack_size(*idle_itr);
+    idle_itr = idle_idx.erase(idle_itr);
+
+    if (collectable) {
+      reclaimed_bytes += remove_account(ctx, account);
+    }
+  }
+
+  ctx.flush();
+
+  return reclaimed_bytes;
+}
+
+
+/**
+ * closeaccount action enables a user with no credit and no bid to remove their records from the contract
+ * 
+ * @param user the user's account name
+ */
+[[eosio::action]]
+void closeaccount(name user) {
+
+  require_auth(user);
+
+  action_context ctx(get_self());
+
+  check(ctx.bids_table.find(user.value) == ctx.bids_table.end(), "you cannot close your account while you have a bid");
+  check(ctx.credit(user).amount == 0, "you must withdraw your credit before closing your account");
+
+  users_index users_table(get_self(), user.value);
+  check(users_table.begin() != users_table.end(), "no user record");
+
+  remove_account(ctx, user);
+
+  ctx.flush();
+}
+
+
+/**
+ * remove_account function erases a user's users, credits, principals and activity records and
+ * removes the user from the system user count and CLS
+ * 
+ * @param ctx the action context
+ * @param account the user's account name
+ * 
+ * @return The approximate number of bytes of RAM reclaimed
+ */
+uint64_t remove_account(action_context &ctx, name account) {
+  uint64_t reclaimed_bytes = 0;
+
+  users_index users_table(get_self(), account.value);
+  auto user_iterator = users_table.begin();
+  bool registered = (user_iterator != users_table.end());
+  if (registered) {
+    reclaimed_bytes += ROW_OVERHEAD_BYTES + pack_size(*user_iterator);
+    users_table.erase(user_iterator);
+  }
+
+  if (ctx.has_credit_record(account)) {
+    reclaimed_bytes += ROW_OVERHEAD_BYTES + pack_size(ctx.credit(account)); // a credit record is a single asset
+    ctx.erase_credit(account);
+  }
+
+  principals_index principals_table(get_self(), get_self().value);
+  auto principal_iterator = principals_table.find(account.value);
+  if (principal_iterator != principals_table.end()) {
+    reclaimed_bytes += ROW_OVERHEAD_BYTES + pack_size(*principal_iterator);
+    principals_table.erase(principal_iterator);
+  }
+
+  auto activity_iterator = ctx.activity_table.find(account.value);
+  if (activity_iterator != ctx.activity_table.end()) {
+    reclaimed_bytes += ROW_OVERHEAD_BYTES + pack_size(*activity_iterator);
+    ctx.activity_table.erase(activity_iterator);
+  }
+
+  // a custodian with no credit has no sub-account balances left
+  custodians_index custodians_table(get_self(), get_self().value);
+  auto custodian_iterator = custodians_table.find(account.value);
+  if (custodian_iterator != custodians_table.end() && custodian_iterator->held.amount == 0) {
+    reclaimed_bytes += ROW_OVERHEAD_BYTES + pack_size(*custodian_iterator);
+    custodians_table.erase(custodian_iterator);
+  }
+
+  bidnonces_index bidnonces_table(get_self(), account.value);
+  auto nonces_iterator = bidnonces_table.begin();
+  if (nonces_iterator != bidnonces_table.end()) {
+    reclaimed_bytes += ROW_OVERHEAD_BYTES + pack_size(*nonces_iterator);
+    bidnonces_table.erase(nonces_iterator);
+  }
+
+  // keep the user count and CLS consistent with reguser
+  if (registered && ctx.has_system() && ctx.system().usercount > 0) {
+    ctx.update_system([&](auto &sys) {
+      sys.usercount -= 1;
+      sys.cls -= UCLS;
+    });
+  }
+
+  return reclaimed_bytes;
+}
+
+
+/**
+ * create_auction function creates a new auction record for the NFT with the specified ID
+ * The auction record contains the auction start, end and end-of-bidding times. With the seasonlen parameter
+ * it is written to the scope of the season in which the auction starts.
+ * This function is called by the bid action, i.e. the system responds to user activity
+ * 
+ * @param ctx the action context
+ * @param nft_id The ID of the NFT to be auctioned.
+ */
+void create_auction(action_context &ctx, uint64_t nft_id) {
+
+  // get the auction length and bidding period length
+  const uint32_t AUCTION_LENGTH_SECONDS = stoi(ctx.parameter(name("auctperiod"), "auction period is undefined"));
+  const uint32_t AUCTION_BIDDING_PERIOD_SECONDS = stoi(ctx.parameter(name("bidperiod"), "bidding period is undefined"));
+
+  // work out the start time from the system init time
+  time_point init = ctx.system().init;
+
+  uint64_t init_secs = init.sec_since_epoch();
+  uint64_t now_secs = ctx.now().sec_since_epoch();
+
+  // if we are in the cooldown period then abandon attempt to start a new auction
+  cronacle_rules::auction_window window = cronacle_rules::window_at(init_secs, now_secs, AUCTION_LENGTH_SECONDS, AUCTION_BIDDING_PERIOD_SECONDS);
+  check(window.bidding_open, "bidding is not permitted outside of the bidding period");
+
+  time_point start = time_point(seconds(window.start_secs));
+  time_point bidding_end = time_point(seconds(window.bidding_end_secs));
+  time_point end = time_point(milliseconds(window.end_ms)); // 1 millisecond before possible next auction
+
+  // calculate the number of the auction, which continues from the previous season and across a clear of the
+  // auctions table, so that the bid history rows of earlier numbers are never reused
+  uint32_t next_number = ctx.last_auction_number() + 1;
+
+  // with the seasonlen parameter the auction is written to its season's scope
+  uint64_t scope = get_self().value;
+  if (ctx.enabled(name("seasonlen"))) {
+    const uint32_t SEASON_LENGTH_SECONDS = stoi(ctx.parameter(name("seasonlen"), "season length is undefined"));
+    scope = cronacle_rules::season_at(init_secs, window.start_secs, SEASON_LENGTH_SECONDS);
+  }
+
+  // write the record
+  ctx.open_auction(scope, [&](auto &a) {
+    a.number = next_number;
+    a.nftid = nft_id;
+    a.start = start;
+    a.bidding_end = bidding_end;
+    a.end = end;
+  });
+
+  // the pre-bids filed against the nft become the auction's opening bids
+  apply_prebids(ctx, nft_id);
+}
+
+
+
+/**
+ * add_bid function is called by the bid action. It adds a bid to the bids table, but only if the bid is higher
+ * than the current highest bid
+ * 
+ * @param ctx the action context
+ * @param user the user who is placing the bid
+ * @param nft_id the id of the NFT that is being bid on
+ * @param bidamount the amount of the bid
+ * 
+ * @return BID_PLACED, or BID_SEALED if the bid is held until bidding ends
+ */
+uint8_t add_bid(action_context &ctx, name user, uint64_t nft_id, asset bidamount) {
+
+  bids_index &bids_table = ctx.bids_table;
+
+  // find the winning bid
+  auto amt_idx = bids_table.get_index<"byamount"_n>();
+  auto amt_itr = amt_idx.rbegin();
+
+  asset bid_to_beat = ctx.zero(); // initialise to zero bid
+  if (amt_itr != amt_idx.rend()) {
+    bid_to_beat = amt_itr->bidamount;
+  }
+
+  /* debugging code: 
+
+  const string bidstr = bidamount.to_string();
+  const string incrstr = smallest_increment.to_string();
+  const string bidtobeatstr = bid_to_beat.to_string();
+  const string diffstr = (bidamount - bid_to_beat).to_string();
+  string result = "";
+  if ((bidamount - bid_to_beat) >= smallest_increment) {
+    result = "success";
+  } else {
+    result = "fail";
+  }
+  const string debugstr = "bid: " + bidstr + " increment: "
+   + incrstr + " bid to beat: " + bidtobeatstr + " difference: " + diffstr
+   + " result: " + result;
+
+  check(false, debugstr);
+
+  end of debugging code */
+
+  extended_symbol currency = ctx.currency();
+  int currency_multiplier = intPower(10, currency.get_symbol().precision());
+
+  // get the minimum bid increment parameter
+  asset MINIMUM_BID_INCREMENT = minimum_bid(ctx);
+
+  // get the bidstep parameter
+  asset BIDSTEP_INCREMENT = asset(stoi(ctx.parameter(name("bidstep"), "bidstep parameter is not defined")) * currency_multiplier, currency.get_symbol());
+
+  asset minimum_next_bid = asset(cronacle_rules::minimum_next_bid(bid_to_beat.amount, MINIMUM_BID_INCREMENT.amount, BIDSTEP_INCREMENT.amount), currency.get_symbol());
+  
+  const string bid_amount_msg = "the highest bid is currently " + bid_to_beat.to_string() + ". you must bid at least " + minimum_next_bid.to_string();
+  check(bidamount >= minimum_next_bid, bid_amount_msg);
+
+  // in the final window of the bidding period the bid is sealed and settled when bidding ends
+  if (in_sealed_window(ctx)) {
+    seal_bid(ctx, user, nft_id, bidamount);
+    return BID_SEALED;
+  }
+
+  store_bid(ctx, user, nft_id, bidamount, ctx.now());
+  return BID_PLACED;
+}
+
+
+/**
+ * store_bid function writes an accepted bid to the bids table, replacing the bidder's previous bid or, if the
+ * table holds 3 bids, the lowest bid, and records it in the auction's bid history
+ * 
+ * @param ctx the action context
+ * @param user the user who placed the bid
+ * @param nft_id the id of the NFT that is being bid on
+ * @param bidamount the amount of the bid
+ * @param bidtime the time the bid was placed
+ */
+void store_bid(action_context &ctx, name user, uint64_t nft_id, asset bidamount, time_point bidtime) {
+
+  bids_index &bids_table = ctx.bids_table;
+  auto amt_idx = bids_table.get_index<"byamount"_n>();
+
+  // check if we are replacing a previous bid by the same user
+  auto userbid_itr = bids_table.find(user.value);
+  if (userbid_itr != bids_table.end()) {
+    // modify user's bid
+    bids_table.modify(userbid_itr, get_self(), [&](auto &b) {
+      b.bidamount = bidamount;
+    });
+  } else {
+    // at this point we are adding a top bid that from a user who has not bid before
+    // drop the lowest bid from the bids table (if necessary) and emplace the new bid
+
+    // count the number of bids, which never exceeds 3
+    uint8_t bids_count = 0;
+    auto bids_itr = bids_table.begin();
+    while (bids_itr != bids_table.end() && bids_count < 3) {
+      bids_count++;
+      bids_itr++;
+    }
+
+    // if there are 3 bids then erase the lowest one
+    if (bids_count == 3) {
+      auto lowest_bid_itr = amt_idx.begin();
+      amt_idx.erase(lowest_bid_itr);
+    }
+
+    // add new top bid
+    bids_table.emplace(
+      get_self(), [&](auto &b) {
+        b.bidtime = bidtime;
+        b.bidder = user;
+        b.bidamount = bidamount;
+        b.nftid = nft_id;        
+      });
+
+  }
+
+  record_bid_history(ctx, user, bidamount, bidtime);
+}
+
+
+/**
+ * minimum_bid function returns the minimumbid parameter as an amount of the credit currency
+ * 
+ * @param ctx the action context
+ */
+asset minimum_bid(action_context &ctx) {
+  extended_symbol currency = ctx.currency();
+  int currency_multiplier = intPower(10, currency.get_symbol().precision());
+
+  return asset(stoi(ctx.parameter(name("minimumbid"), "minimumbid parameter is not defined")) * currency_multiplier, currency.get_symbol());
+}
+
+
+/**
+ * in_sealed_window function returns true if the latest auction is in the final batchwindow seconds of its
+ * bidding period. Bids are never sealed if the batchwindow parameter is undefined or 0
+ * 
+ * @param ctx the action context
+ */
+bool in_sealed_window(action_context &ctx) {
+  if (!ctx.enabled(name("batchwindow"))) return false;
+
+  uint32_t BATCH_WINDOW_SECONDS = stoi(ctx.parameter(name("batchwindow"), "batchwindow parameter is not defined"));
+
+  const auction *latest = ctx.latest_auction();
+  if (latest == nullptr) return false;
+
+  return ctx.now() > latest->bidding_end - seconds(BATCH_WINDOW_SECONDS);
+}
+
+
+/**
+ * seal_bid function holds a bid placed in the final window of the bidding period in the sealedbids table.
+ * A bidder has one sealed bid, which a new bid replaces. When the table holds MAX_SEALED_BIDS bids, a new
+ * bidder must outbid the lowest of them, which is dropped
+ * 
+ * @param ctx the action context
+ * @param user the user who placed the bid
+ * @param nft_id the id of the NFT that is being bid on
+ * @param bidamount the amount of the bid
+ */
+void seal_bid(action_context &ctx, name user, uint64_t nft_id, asset bidamount) {
+
+  const auction *latest = ctx.latest_auction();
+  check(latest != nullptr, "auction record is undefined");
+
+  sealedbids_index sealedbids_table(get_self(), get_self().value);
+  auto sealed_iterator = sealedbids_table.find(user.value);
+
+  if (sealed_iterator != sealedbids_table.end()) {
+    sealedbids_table.modify(sealed_iterator, get_self(), [&](auto &b) {
+      b.number = latest->number;
+      b.bidtime = ctx.now();
+      b.bidamount = bidamount;
+      b.nftid = nft_id;
+    });
+  } else {
+    uint8_t sealed_count = 0;
+    for (auto count_itr = sealedbids_table.begin(); count_itr != sealedbids_table.end() && sealed_count < MAX_SEALED_BIDS; count_itr++) {
+      sealed_count++;
+    }
+
+    if (sealed_count == MAX_SEALED_BIDS) {
+      auto amt_idx = sealedbids_table.get_index<"byamount"_n>();
+      auto lowest_itr = amt_idx.begin();
+      check(bidamount > lowest_itr->bidamount, "the auction has " + to_string(MAX_SEALED_BIDS) + " sealed bids. you must bid more than " + lowest_itr->bidamount.to_string());
+      amt_idx.erase(lowest_itr);
+    }
+
+    sealedbids_table.emplace(get_self(), [&](auto &b) {
+      b.number = latest->number;
+      b.bidtime = ctx.now();
+      b.bidder = user;
+      b.bidamount = bidamount;
+      b.nftid = nft_id;
+    });
+  }
+
+  print("your bid is sealed until bidding ends");
+}
+
+
+/**
+ * clear_sealed function settles the sealed bids of the latest auction once its bidding has ended. The highest
+ * sealed bid that beats the open bidding by the bidstep and is covered by the bidder's credit at this moment
+ * becomes the winning bid; between equal bids the earliest wins. Then all the sealed bids are deleted.
+ * Called by claim and close_auction, so an auction is cleared by whichever comes first
+ * 
+ * @param ctx the action context
+ */
+void clear_sealed(action_context &ctx) {
+
+  sealedbids_index sealedbids_table(get_self(), get_self().value);
+  if (sealedbids_table.begin() == sealedbids_table.end()) return;
+
+  const auction *latest = ctx.latest_auction();
+  uint32_t number = (latest != nullptr) ? latest->number : 0;
+
+  // the highest open bid
+  auto bid_idx = ctx.bids_table.get_index<"byamount"_n>();
+  auto bid_itr = bid_idx.rbegin();
+  asset bid_to_beat = (bid_itr != bid_idx.rend()) ? bid_itr->bidamount : ctx.zero();
+
+  extended_symbol currency = ctx.currency();
+  int currency_multiplier = intPower(10, currency.get_symbol().precision());
+  asset BIDSTEP_INCREMENT = asset(stoi(ctx.parameter(name("bidstep"), "bidstep parameter is not defined")) * currency_multiplier, currency.get_symbol());
+  asset minimum_next_bid = asset(cronacle_rules::minimum_next_bid(bid_to_beat.amount, minimum_bid(ctx).amount, BIDSTEP_INCREMENT.amount), currency.get_symbol());
+
+  // sealed bids of another auction, which maintain can leave behind when it clears the auctions table, are ignored
+  auto amt_idx = sealedbids_table.get_index<"byamount"_n>();
+  auto winner_itr = amt_idx.rend();
+  for (auto sealed_itr = amt_idx.rbegin(); sealed_itr != amt_idx.rend(); sealed_itr++) {
+    if (winner_itr != amt_idx.rend() && sealed_itr->bidamount < winner_itr->bidamount) break;
+    if (sealed_itr->bidamount < minimum_next_bid) break;
+    if (sealed_itr->number != number) continue;
+    if (!bid_covered(ctx, sealed_itr->bidder, sealed_itr->nftid, sealed_itr->bidamount)) continue;
+
+    if (winner_itr == amt_idx.rend() || sealed_itr->bidtime < winner_itr->bidtime) {
+      winner_itr = sealed_itr;
+    }
+  }
+
+  if (winner_itr != amt_idx.rend()) {
+    store_bid(ctx, winner_itr->bidder, winner_itr->nftid, winner_itr->bidamount, winner_itr->bidtime);
+  }
+
+  uint32_t erase_budget = MAX_SEALED_BIDS;
+  erase_rows(sealedbids_table, erase_budget);
+}
+
+
+/**
+ * apply_prebids function is called when an nft's auction opens. It adds the highest pre-bids filed against the
+ * nft to the bids table, skipping pre-bids below the minimum bid or above the bidder's credit at that moment,
+ * then deletes the nft's pre-bids
+ * 
+ * @param ctx the action context
+ * @param nft_id the id of the nft whose auction has opened
+ */
+void apply_prebids(action_context &ctx, uint64_t nft_id) {
+
+  prebids_index prebids_table(get_self(), nft_id);
+  auto amt_idx = prebids_table.get_index<"byamount"_n>();
+
+  asset minimum = minimum_bid(ctx);
+  uint8_t applied = 0;
+
+  // the bids table is empty when an auction opens, so a bidder's credit is not locked in another bid
+  for (auto prebid_itr = amt_idx.rbegin(); prebid_itr != amt_idx.rend() && applied < 3; prebid_itr++) {
+    if (prebid_itr->bidamount < minimum) break;
+    if (!bid_covered(ctx, prebid_itr->bidder, nft_id, prebid_itr->bidamount)) continue;
+
+    ctx.bids_table.emplace(get_self(), [&](auto &b) {
+      b.bidtime = prebid_itr->bidtime;
+      b.bidder = prebid_itr->bidder;
+      b.bidamount = prebid_itr->bidamount;
+      b.nftid = nft_id;
+    });
+    record_bid_history(ctx, prebid_itr->bidder, prebid_itr->bidamount, prebid_itr->bidtime);
+    applied++;
+  }
+
+  clear_prebids(nft_id);
+}
+
+
+/**
+ * clear_prebids function deletes the pre-bids filed against an nft
+ * 
+ * @param nft_id the id of the nft
+ */
+void clear_prebids(uint64_t nft_id) {
+  prebids_index prebids_table(get_self(), nft_id);
+  uint32_t erase_budget = MAX_PREBIDS;
+  erase_rows(prebids_table, erase_budget);
+}
+
+
+/**
+ * record_bid_history function writes a bid into the latest auction's ring buffer, overwriting the oldest slot
+ * 
+ * @param ctx the action context
+ * @param user the user who placed the bid
+ * @param bidamount the amount of the bid
+ * @param bidtime the time the bid was placed, which is earlier than the action for a sealed bid settled when
+ * bidding ends, and before the auction's start for a pre-bid
+ */
+void record_bid_history(action_context &ctx, name user, asset bidamount, time_point bidtime) {
+
+  const auction *latest = ctx.latest_auction();
+  check(latest != nullptr, "auction record is undefined");
+
+  // a pre-bid is recorded at the auction's start
+  uint32_t offset = (bidtime > latest->start) ? bidtime.sec_since_epoch() - latest->start.sec_since_epoch() : 0;
+  bidslot slot = bidslot{user, (uint64_t)bidamount.amount, offset};
+
+  bidhistory_index bidhistory_table(get_self(), get_self().value);
+  auto history_iterator = bidhistory_table.find(latest->number);
+
+  if (history_iterator == bidhistory_table.end()) {
+    // allocate all of the slots up front so that the record never changes size
+    bidhistory_table.emplace(get_self(), [&](auto &h) {
+      h.number = latest->number;
+      h.slots.resize(BID_HISTORY_SLOTS);
+      h.slots[0] = slot;
+      h.head = 1;
+    });
+  } else {
+    bidhistory_table.modify(history_iterator, get_self(), [&](auto &h) {
+      h.slots[h.head] = slot;
+      h.head = (h.head + 1) % BID_HISTORY_SLOTS;
+    });
+  }
+}
+
+
+/**
+ * get_available_credit function returns the user's total credit minus the amount of the user's winning bid.
+ * A custodian's total credit includes its sub-accounts' balances, which are not available to the custodian,
+ * and a winning bid placed for a sub-account is held in the sub-account's balance.
+ * Called by the bid and withdraw actions.
+ * 
+ * @param ctx the action context
+ * @param user the user's account name
+ * 
+ * @return The user's available credit, i.e. number of tokens deposited.
+ */
+asset get_available_credit(action_context &ctx, name user) {
+  // default values
+  asset winning_bid_amount = ctx.zero();
+
+  // get the user's credit, zero if there is no credit record
+  asset user_total_credit = ctx.credit(user);
+
+  // get the winning bid amount
+  auto amt_idx = ctx.bids_table.get_index<"byamount"_n>();
+  auto bid_itr = amt_idx.rbegin();
+  if (bid_itr != amt_idx.rend()) {
+    if (bid_itr->bidder == user) {
+      winning_bid_amount = bid_itr->bidamount;
+    }
+  }
+
+  custodians_index custodians_table(get_self(), get_self().value);
+  auto custodian_iterator = custodians_table.find(user.value);
+  if (custodian_iterator != custodians_table.end()) {
+    user_total_credit -= custodian_iterator->held;
+    if (winning_bid_amount.amount > 0 && custodian_iterator->bid_for_subaccount(*bid_itr)) {
+      winning_bid_amount = ctx.zero();
+    }
+  }
+
+  return user_total_credit - winning_bid_amount;  
+}
+
+
+/**
+ * get_subaccount_available function returns a sub-account's balance minus the custodian's winning bid, if that
+ * bid was placed for the sub-account
+ * 
+ * @param ctx the action context
+ * @param custodian the custodian's record
+ * @param sub the sub-account
+ */
+asset get_subaccount_available(action_context &ctx, const custodian_record &custodian, const subaccount &sub) {
+  auto amt_idx = ctx.bids_table.get_index<"byamount"_n>();
+  auto bid_itr = amt_idx.rbegin();
+
+  if (bid_itr != amt_idx.rend() && custodian.bid_subaccount == sub.id && custodian.bid_for_subaccount(*bid_itr)) {
+    return sub.amount - bid_itr->bidamount;
+  }
+  return sub.amount;
+}
+
+
+/**
+ * own_credit function returns the user's total credit minus the sub-account balances that the user holds as a
+ * custodian, i.e. the credit that backs the user's own bids
+ * 
+ * @param ctx the action context
+ * @param user the user's account name
+ */
+asset own_credit(action_context &ctx, name user) {
+  asset user_credit = ctx.credit(user);
+
+  custodians_index custodians_table(get_self(), get_self().value);
+  auto custodian_iterator = custodians_table.find(user.value);
+  if (custodian_iterator != custodians_table.end()) {
+    user_credit -= custodian_iterator->held;
+  }
+
+  return user_credit;
+}
+
+
+/**
+ * bid_covered function returns true if the bidder's credit covers a bid that replaces the bidder's other bids
+ * in the current auction. Called when sealed bids and pre-bids are applied. A custodian's bid placed for a
+ * sub-account is covered by the sub-account's balance, and its own bid by its credit without the sub-account
+ * balances
+ * 
+ * @param ctx the action context
+ * @param bidder the bidder's account name
+ * @param nft_id the id of the nft being bid on
+ * @param bidamount the amount of the bid
+ */
+bool bid_covered(action_context &ctx, name bidder, uint64_t nft_id, asset bidamount) {
+  custodians_index custodians_table(get_self(), get_self().value);
+  auto custodian_iterator = custodians_table.find(bidder.value);
+  if (custodian_iterator == custodians_table.end()) {
+    return ctx.credit(bidder) >= bidamount;
+  }
+
+  const custodian_record &custodian = *custodian_iterator;
+  if (custodian.bid_subaccount != 0 && custodian.bid_nftid == nft_id && custodian.bid_amount == bidamount) {
+    subaccounts_index subaccounts_table(get_self(), bidder.value);
+    auto sub_iterator = subaccounts_table.find(custodian.bid_subaccount);
+    return sub_iterator != subaccounts_table.end() && sub_iterator->amount >= bidamount;
+  }
+
+  return ctx.credit(bidder) - custodian.held >= bidamount;
+}
+
+
+/**
+ * 
+ * close_auction function is called to clean up after an auction has ended.
+ * 
+ * It finds the winning bid, transfers the NFT (or all the assets of a bundle, in one transfer) to the winner,
+ * reduces the winner's credit by the bid amount, records the winner and winning bid in the latest auction
+ * record, clears the bids table, and deletes the NFT record. An auction without bids ends with no winner
+ * and the NFT is relisted or dropped by close_unsold
+ * 
+ * @param ctx the action context
+ * @param nft_id the id of the nft being auctioned
+ */
+void close_auction(action_context &ctx, uint64_t nft_id) {
+
+  // settle the bids sealed in the final bidding window
+  clear_sealed(ctx);
+
+  // find the winning bid
+  bids_index &bids_table = ctx.bids_table;
+  auto amt_idx = bids_table.get_index<"byamount"_n>();
+  auto bid_itr = amt_idx.rbegin();
+
+  if (bid_itr == amt_idx.rend()) {
+    close_unsold(ctx);
+    return;
+  }
+
+  name winner = bid_itr->bidder;
+  asset bidamount = bid_itr->bidamount;
+
+  // the nft record being auctioned
+  auto nft_iterator = ctx.nfts_table.begin();
+  check(nft_iterator != ctx.nfts_table.end(), "nft record is undefined");
+
+  // transfer nft to the winner
+  vector <uint64_t> nftids = nft_iterator->assets();
+  string memo = "winner of auction for nft " + to_string(nft_id);
+  if (nftids.size() > 1) {
+    memo += " and " + to_string(nftids.size() - 1) + " bundled nfts";
+  }
+
+  action transfer = action(
+      permission_level{get_self(), "active"_n},
+      nft_account,
+      "transfer"_n,
+      std::make_tuple(get_self(), winner, nftids, memo));
+
+    transfer.send();
+
+  // reduce the winner's credit by the bid amount
+  check(ctx.has_credit_record(winner), "winning bidder does not have a credit record");
+  check(ctx.credit(winner) >= bidamount, "winning bidder does not have sufficient credit");
+  ctx.set_credit(winner, ctx.credit(winner) - bidamount);
+  settle_subaccount_bid(winner, nft_id, bidamount);
+
+  // record the winner and winning bid in the latest auction record
+  ctx.update_latest_auction([&](auto &a) {
+    a.winner = winner;
+    a.bidamount = bidamount;
   });
+
+  // update the winner's history and the leaderboard
+  record_win(winner, *ctx.latest_auction());
   
   // clear bids table
   auto bid_iterator = bids_table.begin();
@@ -482,108 +1420,475 @@ void close_auction(uint64_t nft_id) {
   }
 
   // delete the nft record
-  nfts_index nfts_table(get_self(), get_self().value);
-  auto nft_iterator = nfts_table.begin();
-  check(nft_iterator != nfts_table.end(), "nft record is undefined");
-  nfts_table.erase(nft_iterator);
+  unindex_bundle(*nft_iterator);
+  ctx.nfts_table.erase(nft_iterator);
+
+}
+
+
+/**
+ * settle_subaccount_bid function debits a sub-account if the winning bid was placed for it by its custodian
+ * 
+ * @param winner the winner of the auction
+ * @param nft_id the id of the nft that was auctioned
+ * @param bidamount the winning bid
+ */
+void settle_subaccount_bid(name winner, uint64_t nft_id, asset bidamount) {
+  custodians_index custodians_table(get_self(), get_self().value);
+  auto custodian_iterator = custodians_table.find(winner.value);
+  if (custodian_iterator == custodians_table.end()) return;
+
+  const custodian_record &custodian = *custodian_iterator;
+  if (custodian.bid_subaccount == 0 || custodian.bid_nftid != nft_id || custodian.bid_amount != bidamount) return;
+
+  subaccounts_index subaccounts_table(get_self(), winner.value);
+  auto sub_iterator = subaccounts_table.find(custodian.bid_subaccount);
+  check(sub_iterator != subaccounts_table.end() && sub_iterator->amount >= bidamount, "internal error, sub-account balance is below its winning bid");
+
+  if (sub_iterator->amount == bidamount) {
+    subaccounts_table.erase(sub_iterator);
+  } else {
+    subaccounts_table.modify(sub_iterator, get_self(), [&](auto &sa) {
+      sa.amount -= bidamount;
+    });
+  }
+
+  custodians_table.modify(custodian_iterator, get_self(), [&](auto &c) {
+    c.held -= bidamount;
+    c.bid_subaccount = 0;
+  });
+}
+
+
+/**
+ * close_unsold function removes the first nft record from the queue after its auction ended with no bids.
+ * The nft is relisted at the back of the queue, or dropped if the dropunsold parameter is switched on.
+ * The auction record, if there is one, is left with no winner and a zero bid amount, which marks it closed
+ * 
+ * @param ctx the action context
+ */
+void close_unsold(action_context &ctx) {
+
+  auto nft_iterator = ctx.nfts_table.begin();
+  check(nft_iterator != ctx.nfts_table.end(), "nft record is undefined");
+
+  if (ctx.latest_auction() != nullptr) {
+    ctx.update_latest_auction([&](auto &a) {
+      a.bidamount = ctx.zero();
+    });
+  }
+
+  nft unsold = *nft_iterator;
+  ctx.nfts_table.erase(nft_iterator);
+
+  if (ctx.enabled(name("dropunsold"))) {
+    clear_prebids(unsold.nftid);
+    unindex_bundle(unsold);
+    return;
+  }
+
+  // relist the nft at the back of the queue
+  auto latest_itr = ctx.nfts_table.rbegin();
+  unsold.number = (latest_itr != ctx.nfts_table.rend()) ? latest_itr->number + 1 : 1;
+
+  ctx.nfts_table.emplace(get_self(), [&](auto &n) {
+    n = unsold;
+  });
+}
+
+
+/**
+ * auction_closed function returns true if the auction has been closed, with a winner or unsold. An auction is
+ * opened with a bid amount that has no symbol, and closing it sets the winning bid or a zero amount
+ * 
+ * @param a the auction record
+ */
+bool auction_closed(const auction &a) {
+  return a.winner != name() || a.bidamount.symbol != symbol();
+}
+
+
+/**
+ * record_win function adds a settled auction to the winner's history, updates the winner's totals and
+ * reranks the winner in the leaderboard
+ * 
+ * @param winner the winner of the auction
+ * @param settled the settled auction record
+ */
+void record_win(name winner, const auction &settled) {
+
+  wins_index wins_table(get_self(), winner.value);
+  wins_table.emplace(get_self(), [&](auto &w) {
+    w.number = settled.number;
+    w.nftid = settled.nftid;
+    w.end = settled.end;
+    w.bidamount = settled.bidamount;
+  });
+
+  // update the winner's totals
+  uint32_t total_wins = 1;
+  asset total_spend = settled.bidamount;
+
+  winstats_index winstats_table(get_self(), winner.value);
+  auto winstat_iterator = winstats_table.begin();
+  if (winstat_iterator == winstats_table.end()) {
+    winstats_table.emplace(get_self(), [&](auto &w) {
+      w.wins = total_wins;
+      w.spend = total_spend;
+    });
+  } else {
+    total_wins += winstat_iterator->wins;
+    total_spend += winstat_iterator->spend;
+    winstats_table.modify(winstat_iterator, get_self(), [&](auto &w) {
+      w.wins = total_wins;
+      w.spend = total_spend;
+    });
+  }
+
+  // rerank the winner in the leaderboard
+  leaderboard_index leaderboard_table(get_self(), get_self().value);
+  auto leaderboard_iterator = leaderboard_table.begin();
+
+  vector<leader> leaders;
+  if (leaderboard_iterator != leaderboard_table.end()) {
+    leaders = leaderboard_iterator->leaders;
+  }
+
+  leaders.erase(std::remove_if(leaders.begin(), leaders.end(), [&](const leader &l) { return l.account == winner; }), leaders.end());
+
+  auto position = std::find_if(leaders.begin(), leaders.end(), [&](const leader &l) { return l.spend < total_spend; });
+  if (position == leaders.end() && leaders.size() >= LEADERBOARD_SIZE) return; // not a top spender
+
+  leaders.insert(position, leader{winner, total_wins, total_spend});
+  if (leaders.size() > LEADERBOARD_SIZE) {
+    leaders.pop_back();
+  }
+
+  if (leaderboard_iterator == leaderboard_table.end()) {
+    leaderboard_table.emplace(get_self(), [&](auto &l) {
+      l.leaders = leaders;
+    });
+  } else {
+    leaderboard_table.modify(leaderboard_iterator, get_self(), [&](auto &l) {
+      l.leaders = leaders;
+    });
+  }
+}
+
+
+/**
+ * bid action records the details of a user bid.
+ * The system takes the opportunity to also store the BTC and FREEOS prices.
+ * 
+ * If the user is registered, the system is open for business, the user has enough credit, and the
+ * auction is open for bidding, then add the user's bid to the bids table
+ * 
+ * A client that may resubmit a bid passes a nonzero nonce. If the nonce is among the user's last
+ * BID_NONCE_SLOTS bid nonces, the bid has already been accepted and the action only prints its outcome
+ * 
+ * @param user the user who is bidding
+ * @param nft_id the id of the nft being bid on
+ * @param bidamount the amount of credit the user is bidding
+ * @param nonce optional, chosen by the client to identify the bid
+ */
+[[eosio::action]]
+void bid(name user, uint64_t nft_id, asset bidamount, binary_extension<uint64_t> nonce) {
+  require_auth(user);
+
+  uint64_t bid_nonce = nonce.value_or(0);
+  if (bid_nonce != 0 && repeated_bid(user, bid_nonce, nft_id, bidamount)) return;
+
+  action_context ctx(get_self());
+
+  uint8_t outcome = place_bid(ctx, user, nft_id, bidamount, get_available_credit(ctx, user));
+
+  if (bid_nonce != 0) {
+    record_bid_nonce(user, bid_nonce, nft_id, bidamount, outcome);
+  }
+
+  ctx.flush();
+}
+
+
+/**
+ * place_bid function is called by the bid and subbid actions. It checks the bidder and the bid and routes the
+ * bid to the current auction, opening or closing auctions as necessary
+ * 
+ * @param ctx the action context
+ * @param user the user who is bidding
+ * @param nft_id the id of the nft being bid on
+ * @param bidamount the amount of credit the user is bidding
+ * @param available_credit the credit available for the bid
+ * 
+ * @return BID_PLACED, or BID_SEALED if the bid is held until bidding ends
+ */
+uint8_t place_bid(action_context &ctx, name user, uint64_t nft_id, asset bidamount, asset available_credit) {
+
+  touch(ctx, user);
+
+  // check that the user is registered
+  users_index users_table(get_self(), user.value);
+  auto user_iterator = users_table.begin();
+  check(user_iterator != users_table.end(), "you must be registered in order to bid");
+
+  // check if the system is open for business
+  time_point now = ctx.now();
+  check(now >= ctx.system().init, "the auction system is not open for business");
+
+  // check the user has enough available credit to support the bid
+  check(available_credit >= bidamount, "you do not have sufficient credit to place your bid");
+
+  // The user should be bidding on either:
+  // 1. The first nft in the nfts table while the current auction is active
+  // 2. The second nft in the nfts table. This signals that a new auction has begun
+
+  // what are the first and second nft_ids?
+  // If there is no first nft record then nothing is on offer at this time
+  // Second nft_id = 0 if there is no second nft record
+  auto nft_iterator = ctx.nfts_table.begin();
+  check(nft_iterator != ctx.nfts_table.end(), "no nft is offered for sale at this time");
+  uint64_t first_nft = nft_iterator->nftid;
+  nft_iterator++;
+  uint64_t second_nft = (nft_iterator != ctx.nfts_table.end()) ? nft_iterator->nftid : 0;
+
+  // auction/bid algorithm *******************************
+  const string no_bid_msg = "bidding is not open on this nft";
+
+  // get the latest auction record
+  cronacle_rules::latest_auction latest = {false, 0, 0, 0, 0};
+  const auction *latest_record = ctx.latest_auction();
+  if (latest_record != nullptr) {
+    latest = {true, latest_record->nftid, latest_record->start.time_since_epoch().count(),
+      latest_record->bidding_end.time_since_epoch().count(), latest_record->end.time_since_epoch().count()};
+  }
+
+  uint8_t outcome = BID_PLACED;
+
+  switch (cronacle_rules::route_bid(nft_id, first_nft, second_nft, latest, now.time_since_epoch().count())) {
+    case cronacle_rules::bid_route::not_offered:
+      check(false, no_bid_msg);
+      break;
+
+    case cronacle_rules::bid_route::bidding_ended:
+      check(false, "bidding has ended for the nft");
+      break;
+
+    case cronacle_rules::bid_route::add_bid:
+      outcome = add_bid(ctx, user, nft_id, bidamount);
+      break;
+
+    case cronacle_rules::bid_route::open_first:
+      // create the auction for the first nft
+      create_auction(ctx, nft_id); // will throw 'assert error' if in the cooldown period
+
+      // add the bid
+      outcome = add_bid(ctx, user, nft_id, bidamount);
+      break;
+
+    case cronacle_rules::bid_route::close_and_open:
+      // valid bid for second nft, which means that bidding for the first nft has ended
+      close_auction(ctx, first_nft); // clear bids table + close auction record
+
+      // create an auction record for the second nft
+      create_auction(ctx, nft_id);  // will throw 'assert error' if in the cooldown period
+
+      // add the user bid
+      outcome = add_bid(ctx, user, nft_id, bidamount);
+      break;
+
+    case cronacle_rules::bid_route::close_and_reopen:
+      // the only nft in the queue, whose auction is over. Closing it relists the nft if no one bid, unless a
+      // claim has already closed the auction and relisted the nft
+      if (!auction_closed(*latest_record)) {
+        close_auction(ctx, first_nft);
+      }
+      check(ctx.nfts_table.begin() != ctx.nfts_table.end() && ctx.nfts_table.begin()->nftid == nft_id, "bidding has ended for the nft");
+
+      create_auction(ctx, nft_id);  // will throw 'assert error' if in the cooldown period
+      outcome = add_bid(ctx, user, nft_id, bidamount);
+      break;
+  }
+
+  return outcome;
+}
+
+
+/**
+ * subbid action places a custodian's bid for one of its sub-accounts. The bid is the custodian's bid in the
+ * auction, limited by the sub-account's available balance, and a won auction is paid from the sub-account.
+ * A custodian has one bid in an auction, so a later bid, for itself or another sub-account, replaces it
+ * 
+ * @param custodian the custodian's account name
+ * @param sub_id the id of the sub-account
+ * @param nft_id the id of the nft being bid on
+ * @param bidamount the amount of credit the custodian is bidding
+ */
+[[eosio::action]]
+void subbid(name custodian, uint64_t sub_id, uint64_t nft_id, asset bidamount) {
+  require_auth(custodian);
+
+  action_context ctx(get_self());
+
+  asset available_credit = ctx.zero();
+  {
+    custodians_index custodians_table(get_self(), get_self().value);
+    auto custodian_iterator = custodians_table.find(custodian.value);
+    check(custodian_iterator != custodians_table.end(), "you do not have sub-accounts");
+
+    subaccounts_index subaccounts_table(get_self(), custodian.value);
+    auto sub_iterator = subaccounts_table.find(sub_id);
+    check(sub_iterator != subaccounts_table.end(), "sub-account " + to_string(sub_id) + " has no balance");
+
+    available_credit = get_subaccount_available(ctx, *custodian_iterator, *sub_iterator);
+  }
+
+  place_bid(ctx, custodian, nft_id, bidamount, available_credit);
+
+  // the custodian record is read again, as closing the previous auction may have changed it
+  custodians_index custodians_table(get_self(), get_self().value);
+  auto custodian_iterator = custodians_table.find(custodian.value);
+  custodians_table.modify(custodian_iterator, get_self(), [&](auto &c) {
+    c.bid_subaccount = sub_id;
+    c.bid_nftid = nft_id;
+    c.bid_amount = bidamount;
+  });
+
+  ctx.flush();
+}
+
+
+/**
+ * repeated_bid function looks up a bid nonce among the user's recent bid nonces. If it is there, the function
+ * prints the outcome of the original bid. A nonce reused for a different bid is rejected
+ * 
+ * @param user the user who is bidding
+ * @param nonce the bid's nonce
+ * @param nft_id the id of the nft being bid on
+ * @param bidamount the amount of credit the user is bidding
+ * 
+ * @return true if the bid has already been accepted
+ */
+bool repeated_bid(name user, uint64_t nonce, uint64_t nft_id, asset bidamount) {
+
+  bidnonces_index bidnonces_table(get_self(), user.value);
+  auto nonces_iterator = bidnonces_table.begin();
+  if (nonces_iterator == bidnonces_table.end()) return false;
+
+  for (const nonce_slot &slot : nonces_iterator->slots) {
+    if (slot.nonce != nonce) continue;
+
+    check(slot.nftid == nft_id && slot.bidamount == bidamount, "the nonce was used for a different bid");
+
+    string outcome_msg = (slot.outcome == BID_SEALED) ? " is sealed until bidding ends" : " was placed";
+    print("your bid of " + bidamount.to_string() + " on nft " + to_string(nft_id) + outcome_msg);
+    return true;
+  }
+
+  return false;
+}
+
+
+/**
+ * record_bid_nonce function writes an accepted bid's nonce into the user's ring buffer, overwriting the oldest slot
+ * 
+ * @param user the user who placed the bid
+ * @param nonce the bid's nonce
+ * @param nft_id the id of the nft that was bid on
+ * @param bidamount the amount of the bid
+ * @param outcome BID_PLACED or BID_SEALED
+ */
+void record_bid_nonce(name user, uint64_t nonce, uint64_t nft_id, asset bidamount, uint8_t outcome) {
+
+  nonce_slot slot = nonce_slot{nonce, nft_id, bidamount, outcome};
+
+  bidnonces_index bidnonces_table(get_self(), user.value);
+  auto nonces_iterator = bidnonces_table.begin();
 
+  if (nonces_iterator == bidnonces_table.end()) {
+    // allocate all of the slots up front so that the record never changes size
+    bidnonces_table.emplace(get_self(), [&](auto &n) {
+      n.slots.resize(BID_NONCE_SLOTS, nonce_slot{0, 0, asset(0, bidamount.symbol), 0});
+      n.slots[0] = slot;
+      n.head = 1;
+    });
+  } else {
+    bidnonces_table.modify(nonces_iterator, get_self(), [&](auto &n) {
+      n.slots[n.head] = slot;
+      n.head = (n.head + 1) % BID_NONCE_SLOTS;
+    });
+  }
 }
 
 
 /**
- * bid action records the details of a user bid.
- * The system takes the opportunity to also store the BTC and FREEOS prices.
- * 
- * If the user is registered, the system is open for business, the user has enough credit, and the
- * auction is open for bidding, then add the user's bid to the bids table
+ * prebid action files a bid against an nft that is waiting in the queue. When the nft's auction opens, the
+ * highest pre-bids that are covered by their bidders' credit become the opening bids. A bidder has one
+ * pre-bid per nft: a new pre-bid replaces it and a zero amount withdraws it
  * 
  * @param user the user who is bidding
- * @param nft_id the id of the nft being bid on
- * @param bidamount the amount of credit the user is bidding
+ * @param nft_id the id of the queued nft
+ * @param bidamount the amount of credit the user is bidding, or zero to withdraw the pre-bid
  */
 [[eosio::action]]
-void bid(name user, uint64_t nft_id, asset bidamount) {
+void prebid(name user, uint64_t nft_id, asset bidamount) {
   require_auth(user);
 
-  // check that the user is registered
-  users_index users_table(get_self(), user.value);
-  auto user_iterator = users_table.begin();
-  check(user_iterator != users_table.end(), "you must be registered in order to bid");
+  action_context ctx(get_self());
 
-  // check if the system is open for business
-  system_index system_table(get_self(), get_self().value);
-  auto system_iterator = system_table.begin();
-  check(system_iterator != system_table.end(), "the system record is undefined");
-  time_point init = system_iterator->init;
-  check(current_time_point() >= init, "the auction system is not open for business");
+  prebids_index prebids_table(get_self(), nft_id);
+  auto prebid_iterator = prebids_table.find(user.value);
 
-  // check the user has enough available credit to support the bid
-  asset user_available_credit = get_available_credit(user);
-  check(user_available_credit >= bidamount, "you do not have sufficient credit to place your bid");
+  // withdraw the pre-bid
+  if (bidamount.amount == 0) {
+    check(prebid_iterator != prebids_table.end(), "you do not have a pre-bid on this nft");
+    prebids_table.erase(prebid_iterator);
+    return;
+  }
 
-  // The user should be bidding on either:
-  // 1. The first nft in the nfts table while the current auction is active
-  // 2. The second nft in the nfts table. This signals that a new auction has begun
+  touch(ctx, user);
 
-  // what are the first and second nft_ids?
-  // If there is no first nft record then nothing is on offer at this time
-  // Second nft_id = 0 if there is no second nft record
-  nfts_index nfts_table(get_self(), get_self().value);
-  auto nft_iterator = nfts_table.begin();
-  check(nft_iterator != nfts_table.end(), "no nft is offered for sale at this time");
-  uint64_t first_nft = nft_iterator->nftid;
-  nft_iterator++;
-  uint64_t second_nft = (nft_iterator != nfts_table.end()) ? nft_iterator->nftid : 0;
+  users_index users_table(get_self(), user.value);
+  check(users_table.begin() != users_table.end(), "you must be registered in order to bid");
 
-  // auction/bid algorithm *******************************
-  time_point now = current_time_point();
-  const string no_bid_msg = "bidding is not open on this nft";
+  symbol currency_symbol = ctx.currency().get_symbol();
+  check(bidamount.symbol == currency_symbol, "you must bid in " + currency_symbol.code().to_string());
+  check(bidamount >= minimum_bid(ctx), "you must bid at least " + minimum_bid(ctx).to_string());
+  check(own_credit(ctx, user) >= bidamount, "you do not have sufficient credit to place your bid");
 
-  // check that bidding is for the first or second nft
-  check(nft_id == first_nft || nft_id == second_nft, no_bid_msg);
+  // the nft must be queued and its auction must not have opened
+  auto nft_idx = ctx.nfts_table.get_index<"bynftid"_n>();
+  check(nft_idx.find(nft_id) != nft_idx.end(), "the nft is not in the queue");
 
-  // get the latest auction record
-  // IF it exists AND it is for the nftid being bid, allow bid if time open
-  auctions_index auctions_table(get_self(), get_self().value);
-  auto auction_iterator = auctions_table.rbegin();
-  if (auction_iterator != auctions_table.rend() && auction_iterator->nftid == nft_id) {
-    if (now >= auction_iterator->start && now <= auction_iterator->bidding_end) {
-      add_bid(user, nft_id, bidamount);
-    } else {
-      check(false, "bidding has ended for the nft");
-    }
+  const auction *latest = ctx.latest_auction();
+  check(latest == nullptr || latest->nftid != nft_id, "the auction for the nft has opened, use the bid action");
 
+  if (prebid_iterator != prebids_table.end()) {
+    prebids_table.modify(prebid_iterator, get_self(), [&](auto &p) {
+      p.bidtime = ctx.now();
+      p.bidamount = bidamount;
+    });
   } else {
-    // No, there is no auction record for the nft
-
-    if (nft_id == first_nft) {
-      // create the auction for the first nft
-      create_auction(nft_id); // will throw 'assert error' if in the cooldown period
-
-      // add the bid
-      add_bid(user, nft_id, bidamount);
-
-    } else {
-      // the bid is for the second nft
-
-      // is there an ongoing auction for the first nft? -- i.e. THE WHOLE PERIOD (bidding period + gap)
-      auctions_index auctions_table(get_self(), get_self().value);
-      auto latest_auction_iterator = auctions_table.rbegin();
-
-      check(latest_auction_iterator != auctions_table.rend(), no_bid_msg);
-      bool first_auction_ongoing = (latest_auction_iterator->nftid == first_nft && now >= latest_auction_iterator->start && now <= latest_auction_iterator->end) ? true : false;
-      check(!first_auction_ongoing, no_bid_msg);
-
-      // valid bid for second nft, which means that bidding for the first nft has ended
-      close_auction(first_nft); // clear bids table + close auction record
-
-      // create an auction record for the second nft
-      create_auction(nft_id);  // will throw 'assert error' if in the cooldown period
+    // when the nft has its full number of pre-bids, the new pre-bid replaces the lowest one
+    uint8_t prebids_count = 0;
+    for (auto count_itr = prebids_table.begin(); count_itr != prebids_table.end() && prebids_count < MAX_PREBIDS; count_itr++) {
+      prebids_count++;
+    }
 
-      // add the user bid
-      add_bid(user, nft_id, bidamount);
+    if (prebids_count == MAX_PREBIDS) {
+      auto amt_idx = prebids_table.get_index<"byamount"_n>();
+      auto lowest_itr = amt_idx.begin();
+      check(bidamount > lowest_itr->bidamount, "the nft has " + to_string(MAX_PREBIDS) + " pre-bids. you must bid more than " + lowest_itr->bidamount.to_string());
+      amt_idx.erase(lowest_itr);
     }
+
+    prebids_table.emplace(get_self(), [&](auto &p) {
+      p.bidtime = ctx.now();
+      p.bidder = user;
+      p.bidamount = bidamount;
+    });
   }
+
+  ctx.flush();
 }
 
 
@@ -600,7 +1905,8 @@ void tick() {
 
 /**
  * claim action is called by the user who is the winner of the latest auction, then closes the auction and
- * transfers ownership of the nft to the user
+ * transfers ownership of the nft to the user. If the latest auction had no bids and its nft is the only one in
+ * the queue, any user can call it to close the auction, which relists or drops the nft
  * 
  * @param user the name of the user who is claiming the NFT
  */
@@ -611,26 +1917,41 @@ void claim(name user) {
 
   require_auth(user);
 
+  action_context ctx(get_self());
+
   // get the latest auction record
-  auctions_index auctions_table(get_self(), get_self().value);
-  auto latest_auction_itr = auctions_table.rbegin();
+  const auction *latest = ctx.latest_auction();
 
   // if no latest auction record then halt
-  check(latest_auction_itr != auctions_table.rend(), "there are no active auctions");
+  check(latest != nullptr, "there are no active auctions");
 
   // check that the auction bidding has finished
-  time_point now = current_time_point();
+  time_point now = ctx.now();
 
   // if the bidding is ongoing then halt
-  check(now > latest_auction_itr->bidding_end, "the bidding period has not ended");
+  check(now > latest->bidding_end, "the bidding period has not ended");
+
+  // settle the bids sealed in the final bidding window
+  clear_sealed(ctx);
 
   // get the winning bid
-  bids_index bids_table(get_self(), get_self().value);
-  auto amt_idx = bids_table.get_index<"byamount"_n>();
+  auto amt_idx = ctx.bids_table.get_index<"byamount"_n>();
   auto amt_itr = amt_idx.rbegin();
   
-  // if no winning bid then return silently
-  check(amt_itr != amt_idx.rend(), "there was no winning bid");
+  // an auction without bids is closed here when its nft is the only one in the queue, as there is no second
+  // nft whose first bid would close it
+  if (amt_itr == amt_idx.rend()) {
+    auto nft_iterator = ctx.nfts_table.begin();
+    bool only_nft = nft_iterator != ctx.nfts_table.end() && nft_iterator->nftid == latest->nftid
+      && std::next(nft_iterator) == ctx.nfts_table.end();
+    check(only_nft && latest->winner == name(), "there was no winning bid");
+    check(!auction_closed(*latest), "the auction has already been closed");
+
+    close_unsold(ctx);
+    print("the auction ended without bids and has been closed");
+    ctx.flush();
+    return;
+  }
 
   // check if the user is the winner
   check(user == amt_itr->bidder, "you do not have the winning bid");
@@ -639,36 +1960,126 @@ void claim(name user) {
   uint64_t nftid = amt_itr->nftid;
 
   // close the auction and transfer ownership of the nft to the user
-  close_auction(nftid);
- 
+  close_auction(ctx, nftid);
+
+  ctx.flush();
 }
 
 
 
 /**
  * maintain action enables the contract owner to perform various maintenance tasks on the contract.
+ * The actions that clear tables erase at most MAINTAIN_BATCH_ROWS rows and print a message if rows remain,
+ * in which case the action is repeated. "index bundles" examines at most MAINTAIN_BATCH_ROWS bundle members
+ * from the queue number in cursor, and prints the cursor to run the action again with if entries remain.
+ * "touch" backfills the accounts in accounts, at most MAX_SUBACCOUNT_BATCH of them, and "track credit" at most
+ * MAINTAIN_BATCH_ROWS of them; both use user if the list is empty or absent.
  * 
  * @pre requires authority of the contract
  * 
  * @param action the action to perform
  * @param user the user's account name
+ * @param cursor the queue number that "index bundles" starts from, 0 if absent
+ * @param accounts the accounts that "touch" or "track credit" backfills in one action
  */
 [[eosio::action]]
-void maintain(string action, name user) {
+void maintain(string action, name user, binary_extension<uint64_t> cursor, binary_extension<vector<name>> accounts) {
 
   require_auth(get_self());
 
+  // rows that may still be erased by this action, and whether every table was cleared
+  uint32_t erase_budget = MAINTAIN_BATCH_ROWS;
+  bool cleared = true;
+
+  // credit records are changed through the context so that the holders and totals tables follow
+  action_context ctx(get_self());
+
   if (action == "unregister") {
     users_index users_table(get_self(), user.value);
     auto user_itr = users_table.begin();
     check(user_itr != users_table.end(), "no user record");
     users_table.erase(user_itr);
 
-    credits_index credits_table(get_self(), user.value);
-    auto credit_itr = credits_table.begin();
+    check(ctx.has_credit_record(user), "no credit record");
+    ctx.erase_credit(user);
+
+    principals_index principals_table(get_self(), get_self().value);
+    auto principal_itr = principals_table.find(user.value);
+    if (principal_itr != principals_table.end()) {
+      principals_table.erase(principal_itr);
+    }
+  }
+
+  // the accounts that a backfill action applies to
+  vector<name> batch = accounts.value_or();
+  if (batch.empty()) {
+    batch.push_back(user);
+  }
+
+  // add users registered before activity tracking to the gc candidates. An account that already has an activity
+  // record is skipped, so that the backfill does not reset its idle time
+  if (action == "touch") {
+    check(batch.size() <= MAX_SUBACCOUNT_BATCH, "at most " + to_string(MAX_SUBACCOUNT_BATCH) + " accounts may be touched at once");
+
+    uint32_t touched = 0;
+    for (const name &account : batch) {
+      users_index users_table(get_self(), account.value);
+      check(users_table.begin() != users_table.end(), "no user record for " + account.to_string());
+      if (ctx.activity_table.find(account.value) == ctx.activity_table.end()) {
+        touch(ctx, account);
+        touched++;
+      }
+    }
+    print(to_string(touched) + " of " + to_string(batch.size()) + " accounts were touched");
+  }
+
+  // add the credit of users who deposited before the holders and totals tables existed to those tables. Until
+  // every such user has been tracked, the totals reported by balances and allbalances leave their credit out.
+  // An account whose credit is already tracked is skipped
+  if (action == "track credit") {
+    check(batch.size() <= MAINTAIN_BATCH_ROWS, "at most " + to_string(MAINTAIN_BATCH_ROWS) + " accounts may be tracked at once");
+
+    uint32_t tracked = 0;
+    for (const name &account : batch) {
+      check(ctx.has_credit_record(account), "no credit record for " + account.to_string());
+      if (ctx.holders_table.find(account.value) == ctx.holders_table.end()) {
+        ctx.holders_table.emplace(get_self(), [&](auto &h) {
+          h.account = account;
+        });
+        ctx.adjust_totals(ctx.credit(account), ctx.zero());
+        tracked++;
+      }
+    }
+    print(to_string(tracked) + " of " + to_string(batch.size()) + " accounts were tracked");
+  }
+
+  // write the bundle members rows of bundles queued before the bundlenfts table existed. A bundle whose first
+  // member has its row was indexed whole, by addbundle or an earlier batch, and costs one lookup to skip
+  if (action == "index bundles") {
+    nfts_index nfts_table(get_self(), get_self().value);
+    bundlenfts_index bundlenfts_table(get_self(), get_self().value);
+    uint32_t member_budget = MAINTAIN_BATCH_ROWS;
+
+    auto nft_iterator = nfts_table.lower_bound(cursor.value_or(0));
+    while (nft_iterator != nfts_table.end() && member_budget > 0) {
+      // an entry without a bundle, or with an indexed one, counts as one member. A bundle is indexed whole, so
+      // the last one may take the batch over the limit by fewer than MAX_BUNDLE_SIZE members
+      uint32_t examined = 1;
+      const std::vector<uint64_t> members = nft_iterator->bundle.value_or();
+      if (!members.empty()) {
+        auto first_member = bundlenfts_table.find(members.front());
+        if (first_member == bundlenfts_table.end() || first_member->head != nft_iterator->nftid) {
+          index_bundle(*nft_iterator);
+          examined = members.size();
+        }
+      }
+      member_budget -= std::min(member_budget, examined);
+      nft_iterator++;
+    }
 
-    check(credit_itr != credits_table.end(), "no credit record");
-    credits_table.erase(credit_itr);
+    if (nft_iterator != nfts_table.end()) {
+      print("the batch limit of " + to_string(MAINTAIN_BATCH_ROWS) + " bundle members was reached, run the action again with cursor " + to_string(nft_iterator->number));
+    }
   }
 
   if (action == "set cls") {
@@ -682,11 +2093,7 @@ void maintain(string action, name user) {
 
   if (action == "clear users") {
       users_index users_table(get_self(), get_self().value);
-      auto user_iterator = users_table.begin();
-
-      while (user_iterator != users_table.end()) {
-        user_iterator = users_table.erase(user_iterator);
-      }
+      cleared = erase_rows(users_table, erase_budget) && cleared;
     }
 
     if (action == "clear system") {
@@ -713,21 +2120,15 @@ void maintain(string action, name user) {
     }
 
     if (action == "clear auctions") {
-      auctions_index auctions_table(get_self(), get_self().value);
-      auto auctions_iterator = auctions_table.begin();
-
-      while (auctions_iterator != auctions_table.end()) {
-        auctions_iterator = auctions_table.erase(auctions_iterator);
-      }
+      cleared = clear_auctions(erase_budget) && cleared;
     }
 
     if (action == "clear bids") {
       bids_index bids_table(get_self(), get_self().value);
-      auto bids_iterator = bids_table.begin();
+      cleared = erase_rows(bids_table, erase_budget) && cleared;
 
-      while (bids_iterator != bids_table.end()) {
-        bids_iterator = bids_table.erase(bids_iterator);
-      }
+      sealedbids_index sealedbids_table(get_self(), get_self().value);
+      cleared = erase_rows(sealedbids_table, erase_budget) && cleared;
     }
 
     if (action == "add bids") {
@@ -770,30 +2171,317 @@ void maintain(string action, name user) {
     if (action == "reset") {
       // clear bids
       bids_index bids_table(get_self(), get_self().value);
-      auto bids_iterator = bids_table.begin();
+      cleared = erase_rows(bids_table, erase_budget) && cleared;
 
-      while (bids_iterator != bids_table.end()) {
-        bids_iterator = bids_table.erase(bids_iterator);
-      }
+      sealedbids_index sealedbids_table(get_self(), get_self().value);
+      cleared = erase_rows(sealedbids_table, erase_budget) && cleared;
 
       // clear auctions
-      auctions_index auctions_table(get_self(), get_self().value);
-      auto auctions_iterator = auctions_table.begin();
+      cleared = clear_auctions(erase_budget) && cleared;
+    }
 
-      while (auctions_iterator != auctions_table.end()) {
-        auctions_iterator = auctions_table.erase(auctions_iterator);
+    if (action == "clear credit") {
+      if (ctx.has_credit_record(user)) {
+        ctx.erase_credit(user);
       }
     }
 
-    if (action == "clear credit") {
-      credits_index credits_table(get_self(), user.value);
-      auto credit_iterator = credits_table.begin();
+  ctx.flush();
+
+  if (!cleared) {
+    print("the batch limit of " + to_string(MAINTAIN_BATCH_ROWS) + " rows was reached, run the action again to erase the remaining rows");
+  }
+}
+
+
+/**
+ * clear_auctions function erases the auction records in the contract's scope and in the latest auction's
+ * season scope, and the bid histories. The auction head is kept, so numbering continues from the last auction
+ * and the bid history rows that dropseason erases by number are never those of a later auction. The records of
+ * earlier seasons are erased with the dropseason action
+ * 
+ * @param budget the number of rows that may still be erased, reduced by the number erased
+ * 
+ * @return true if every row was erased
+ */
+bool clear_auctions(uint32_t &budget) {
+  check(legacy_auctions_migrated(), "run the migrate action before clearing the auctions table");
+
+  auctions_index auctions_table(get_self(), get_self().value);
+  bool cleared = erase_rows(auctions_table, budget);
+
+  auctionhead_index auctionhead_table(get_self(), get_self().value);
+  auto head_iterator = auctionhead_table.begin();
+  if (head_iterator != auctionhead_table.end() && head_iterator->scope != get_self().value) {
+    auctions_index season_table(get_self(), head_iterator->scope);
+    cleared = erase_rows(season_table, budget) && cleared;
+  }
+
+  bidhistory_index bidhistory_table(get_self(), get_self().value);
+  cleared = erase_rows(bidhistory_table, budget) && cleared;
+
+  return cleared;
+}
+
+
+/**
+ * erase_rows function erases rows from the start of a table until the table is empty or the budget is spent
+ * 
+ * @param table the table
+ * @param budget the number of rows that may still be erased, reduced by the number erased
+ * 
+ * @return true if the table is empty
+ */
+template<typename Table>
+bool erase_rows(Table &table, uint32_t &budget) {
+  auto row_iterator = table.begin();
+
+  while (row_iterator != table.end() && budget > 0) {
+    row_iterator = table.erase(row_iterator);
+    budget--;
+  }
+
+  return row_iterator == table.end();
+}
+
+
+/**
+ * dropseason action erases the auction records of a past season, and their bid histories, once the season
+ * has been archived, e.g. with tools/cronacle_history. It erases at most MAINTAIN_BATCH_ROWS records and
+ * prints a message if records remain, in which case the action is repeated. The season that holds the latest
+ * auction cannot be dropped
+ * 
+ * @pre requires authority of the contract
+ * 
+ * @param season the season number, which is the scope of its auction records
+ */
+[[eosio::action]]
+void dropseason(uint64_t season) {
+
+  require_auth(get_self());
+
+  check(season > 0, "seasons are numbered from 1");
+
+  auctionhead_index auctionhead_table(get_self(), get_self().value);
+  auto head_iterator = auctionhead_table.begin();
+  check(head_iterator == auctionhead_table.end() || head_iterator->scope != season, "the season holds the latest auction");
 
-      if (credit_iterator != credits_table.end()) {
-        credits_table.erase(credit_iterator);
+  auctions_index auctions_table(get_self(), season);
+  bidhistory_index bidhistory_table(get_self(), get_self().value);
+
+  uint32_t erase_budget = MAINTAIN_BATCH_ROWS;
+  auto auction_iterator = auctions_table.begin();
+  check(auction_iterator != auctions_table.end(), "the season has no auction records");
+
+  while (auction_iterator != auctions_table.end() && erase_budget > 0) {
+    auto history_iterator = bidhistory_table.find(auction_iterator->number);
+    if (history_iterator != bidhistory_table.end()) {
+      bidhistory_table.erase(history_iterator);
+    }
+
+    auction_iterator = auctions_table.erase(auction_iterator);
+    erase_budget--;
+  }
+
+  if (auction_iterator != auctions_table.end()) {
+    print("the batch limit of " + to_string(MAINTAIN_BATCH_ROWS) + " rows was reached, run the action again to erase the remaining rows");
+  }
+}
+
+
+/**
+ * migrate action removes the bynftid and bywinner index entries that contract versions before 0.14.0 wrote
+ * for each auction. It rewrites at most max_rows (and no more than MIGRATE_BATCH_ROWS) auction records and
+ * prints a message if records remain, in which case the action is repeated. The rows still to migrate are
+ * exactly those in the legacy bynftid index, so the action resumes where the previous batch stopped
+ * 
+ * @pre requires authority of the contract
+ * 
+ * @param max_rows the maximum number of auction records to rewrite, greater than zero
+ * 
+ * @return the number of auction records rewritten
+ */
+[[eosio::action]]
+uint32_t migrate(uint32_t max_rows) {
+
+  require_auth(get_self());
+
+  check(max_rows > 0, "max_rows must be greater than zero");
+
+  legacy_auctions_index legacy_table(get_self(), get_self().value);
+  auctions_index auctions_table(get_self(), get_self().value);
+
+  auto nftid_idx = legacy_table.get_index<"bynftid"_n>();
+  auto legacy_itr = nftid_idx.begin();
+
+  uint32_t batch = std::min(max_rows, (uint32_t)MIGRATE_BATCH_ROWS);
+  uint32_t migrated = 0;
+
+  // erasing through the legacy table removes the record with its index entries, and the record is
+  // written back without them
+  while (legacy_itr != nftid_idx.end() && migrated < batch) {
+    auction record = *legacy_itr;
+    nftid_idx.erase(legacy_itr);
+
+    auctions_table.emplace(get_self(), [&](auto &a) {
+      a = record;
+    });
+
+    migrated++;
+    legacy_itr = nftid_idx.begin();
+  }
+
+  if (legacy_itr != nftid_idx.end()) {
+    print("the batch limit was reached, run the action again to migrate the remaining auction records");
+  }
+
+  return migrated;
+}
+
+
+/**
+ * legacy_auctions_migrated function returns true if no auction record has legacy index entries
+ */
+bool legacy_auctions_migrated() {
+  legacy_auctions_index legacy_table(get_self(), get_self().value);
+  auto nftid_idx = legacy_table.get_index<"bynftid"_n>();
+  return nftid_idx.begin() == nftid_idx.end();
+}
+
+
+/**
+ * importstate action loads a chunk of a state snapshot into one table, for bootstrapping test and staging
+ * chains. Rows are inserted, or replace the row with the same primary key. The chunks are produced by the
+ * tools/cronacle_snapshot packer from a dump, which tools/cronacle_export writes from a running contract
+ * 
+ * @pre requires authority of the contract
+ * 
+ * @param table the table to load: users, credits, auctions, auctionhead, nfts, parameters, admins, system,
+ * subaccounts or custodians
+ * @param chunk a packed vector of at most MAX_IMPORT_ROWS rows in the table's snapshot format
+ */
+[[eosio::action]]
+void importstate(name table, vector<char> chunk) {
+
+  require_auth(get_self());
+
+  if (table == "users"_n) {
+    action_context ctx(get_self());
+
+    for (const auto &row : unpack_chunk<user_snapshot>(chunk)) {
+      users_index users_table(get_self(), row.account.value);
+      bool is_new = (users_table.begin() == users_table.end());
+
+      // the link is replaced, or removed for an empty principal, as setprincipal does
+      link_principal(row.account, row.dfinity_principal);
+
+      user imported;
+      imported.time = row.time;
+      imported.proton_account = row.account;
+      imported.dfinity_principal = row.dfinity_principal;
+      upsert_row(users_table, imported);
+
+      // give the user an activity record so that gc can reach the account, dated from the snapshot
+      if (is_new) touch(ctx, row.account, row.time);
+    }
+  } else if (table == "credits"_n) {
+    // loaded through the context so that the holders and totals tables follow
+    action_context ctx(get_self());
+    for (const auto &row : unpack_chunk<credit_snapshot>(chunk)) {
+      ctx.set_credit(row.account, row.amount);
+    }
+    ctx.flush();
+  } else if (table == "auctions"_n) {
+    for (const auto &row : unpack_chunk<auction_snapshot>(chunk)) {
+      auctions_index auctions_table(get_self(), row.scope != 0 ? row.scope : get_self().value);
+      upsert_row(auctions_table, row.record);
+    }
+  } else if (table == "auctionhead"_n) {
+    auctionhead_index auctionhead_table(get_self(), get_self().value);
+    for (auction_head row : unpack_chunk<auction_head>(chunk)) {
+      if (row.scope == 0) row.scope = get_self().value;
+      upsert_row(auctionhead_table, row);
+    }
+  } else if (table == "nfts"_n) {
+    nfts_index nfts_table(get_self(), get_self().value);
+    for (const auto &row : unpack_chunk<nft_snapshot>(chunk)) {
+      nft imported;
+      imported.number = row.number;
+      imported.nftid = row.nftid;
+      if (!row.bundle.empty()) {
+        imported.bundle = row.bundle;
+      }
+
+      // the bundle members follow the entry that the imported row replaces
+      auto replaced_iterator = nfts_table.find(imported.number);
+      if (replaced_iterator != nfts_table.end()) {
+        unindex_bundle(*replaced_iterator);
       }
+      upsert_row(nfts_table, imported);
+      index_bundle(imported);
+    }
+  } else if (table == "parameters"_n) {
+    parameters_index parameters_table(get_self(), get_self().value);
+    for (const auto &row : unpack_chunk<parameter>(chunk)) {
+      upsert_row(parameters_table, row);
+    }
+  } else if (table == "admins"_n) {
+    admins_index admins_table(get_self(), get_self().value);
+    for (const auto &row : unpack_chunk<admin_whitelist>(chunk)) {
+      upsert_row(admins_table, row);
+    }
+  } else if (table == "system"_n) {
+    system_index system_table(get_self(), get_self().value);
+    for (const auto &row : unpack_chunk<system_record>(chunk)) {
+      upsert_row(system_table, row);
+    }
+  } else if (table == "subaccounts"_n) {
+    for (const auto &row : unpack_chunk<subaccount_snapshot>(chunk)) {
+      subaccounts_index subaccounts_table(get_self(), row.custodian.value);
+      subaccount imported;
+      imported.id = row.id;
+      imported.amount = row.amount;
+      upsert_row(subaccounts_table, imported);
     }
+  } else if (table == "custodians"_n) {
+    custodians_index custodians_table(get_self(), get_self().value);
+    for (const auto &row : unpack_chunk<custodian_record>(chunk)) {
+      upsert_row(custodians_table, row);
+    }
+  } else {
+    check(false, "table cannot be imported");
+  }
+}
+
+
+/**
+ * unpack_chunk function unpacks the rows of an importstate chunk
+ * 
+ * @param chunk the packed vector of rows
+ */
+template<typename Row>
+vector<Row> unpack_chunk(const vector<char> &chunk) {
+  vector<Row> rows = unpack<vector<Row>>(chunk);
+  check(rows.size() <= MAX_IMPORT_ROWS, "a chunk may contain at most " + to_string(MAX_IMPORT_ROWS) + " rows");
+  return rows;
+}
+
+
+/**
+ * upsert_row function inserts a row into a table, or replaces the row that has the same primary key
+ * 
+ * @param table the table
+ * @param row the new row
+ */
+template<typename Table, typename Row>
+void upsert_row(Table &table, const Row &row) {
+  auto row_iterator = table.find(row.primary_key());
 
+  if (row_iterator == table.end()) {
+    table.emplace(get_self(), [&](auto &r) { r = row; });
+  } else {
+    table.modify(row_iterator, get_self(), [&](auto &r) { r = row; });
+  }
 }
 
 
@@ -815,12 +2503,59 @@ void addnft(name user, uint32_t number, uint64_t nftid) {
     check(user == get_self(), "action requires authority of the contract or an account listed in the admins table");
   }
   
+  queue_nft(number, {nftid});
+}
+
+
+/**
+ * addbundle adds a bundle of NFTs to the nfts table. The bundle is auctioned in a single auction slot
+ * under the first nft id, and all of its NFTs are transferred to the winner in one transfer
+ * 
+ * @pre requires authority of the contract
+ * 
+ * @param user the account that is calling the action
+ * @param number the number of the bundle in the auction list
+ * @param nftids the ids of the nfts in the bundle
+ */
+[[eosio::action]]
+void addbundle(name user, uint32_t number, vector<uint64_t> nftids) {
+
+  require_auth(user);
+
+  if (!isadmin(user)) {
+    check(user == get_self(), "action requires authority of the contract or an account listed in the admins table");
+  }
+
+  check(nftids.size() >= 2, "a bundle must contain at least 2 nfts");
+  check(nftids.size() <= MAX_BUNDLE_SIZE, "a bundle may contain at most " + to_string(MAX_BUNDLE_SIZE) + " nfts");
+
+  vector<uint64_t> sorted_ids = nftids;
+  std::sort(sorted_ids.begin(), sorted_ids.end());
+  check(std::adjacent_find(sorted_ids.begin(), sorted_ids.end()) == sorted_ids.end(), "a bundle must not contain an nft twice");
+
+  queue_nft(number, nftids);
+}
+
+
+/**
+ * queue_nft function adds an entry to the nfts table. The first id is the nft that is bid on, and
+ * any further ids are stored as the entry's bundle
+ * 
+ * @param number the number of the entry in the auction list, 0 to add it to the end of the list
+ * @param nftids the ids of the nfts in the entry
+ */
+void queue_nft(uint32_t number, const vector<uint64_t> &nftids) {
+
   nfts_index nfts_table(get_self(), get_self().value);
 
-  // check if the nft is not already in the list
+  // check if the nfts are not already in the list, as an entry or in a bundle
   auto nft_idx = nfts_table.get_index<"bynftid"_n>();
-  auto nft_present_itr = nft_idx.find(nftid);
-  check(nft_present_itr == nft_idx.end(), "nft is already in the table");
+  bundlenfts_index bundlenfts_table(get_self(), get_self().value);
+  for (uint64_t nftid : nftids) {
+    auto nft_present_itr = nft_idx.find(nftid);
+    check(nft_present_itr == nft_idx.end(), "nft is already in the table");
+    check(bundlenfts_table.find(nftid) == bundlenfts_table.end(), "nft is already in the table, in a bundle");
+  }
 
   // if 0 passed as the number, then add to the end of the list
   if (number == 0) {    
@@ -835,10 +2570,51 @@ void addnft(name user, uint32_t number, uint64_t nftid) {
   }
 
   // add the nft to the table
-  nfts_table.emplace(get_self(), [&](auto &n) {
+  auto entry_iterator = nfts_table.emplace(get_self(), [&](auto &n) {
     n.number = number;
-    n.nftid = nftid;
+    n.nftid = nftids.front();
+    if (nftids.size() > 1) {
+      n.bundle = vector<uint64_t>(nftids.begin() + 1, nftids.end());
+    }
   });
+  index_bundle(*entry_iterator);
+}
+
+
+/**
+ * index_bundle function writes a bundle members row for each asset of a queue entry's bundle
+ * 
+ * @param entry the nfts table entry
+ */
+void index_bundle(const nft &entry) {
+  if (!entry.bundle.has_value()) return;
+
+  bundlenfts_index bundlenfts_table(get_self(), get_self().value);
+  for (uint64_t member : entry.bundle.value()) {
+    if (bundlenfts_table.find(member) != bundlenfts_table.end()) continue;
+    bundlenfts_table.emplace(get_self(), [&](auto &b) {
+      b.nftid = member;
+      b.head = entry.nftid;
+    });
+  }
+}
+
+
+/**
+ * unindex_bundle function erases the bundle members rows of a queue entry that leaves the queue
+ * 
+ * @param entry the nfts table entry
+ */
+void unindex_bundle(const nft &entry) {
+  if (!entry.bundle.has_value()) return;
+
+  bundlenfts_index bundlenfts_table(get_self(), get_self().value);
+  for (uint64_t member : entry.bundle.value()) {
+    auto member_iterator = bundlenfts_table.find(member);
+    if (member_iterator != bundlenfts_table.end() && member_iterator->head == entry.nftid) {
+      bundlenfts_table.erase(member_iterator);
+    }
+  }
 }
 
 
@@ -864,6 +2640,8 @@ void removenft(name user, uint32_t number) {
   auto nft_itr = nfts_table.find(number);
 
   check(nft_itr != nfts_table.end(), "nft number not found");
+  clear_prebids(nft_itr->nftid);
+  unindex_bundle(*nft_itr);
   nfts_table.erase(nft_itr);
 }
 
@@ -975,10 +2753,6 @@ void updateadmin(name account, bool remove) {
  */
 extended_symbol get_currency() {
 
-  char code[13];
-  uint8_t precision;
-  char contract[13];
-
   name paramname = name("currency");
   parameters_index parameters_table(get_self(), get_self().value);
   auto parameter_iterator = parameters_table.find(paramname.value);
@@ -986,14 +2760,7 @@ extended_symbol get_currency() {
   // check if the parameter is in the table or not
   check(parameter_iterator != parameters_table.end(), "currency parameter is not defined");
 
-  string currency = parameter_iterator->value;
-  char* curr = currency.data();
-  sscanf(curr, "%d %s %s", &precision, code, contract);
-
-  // check(false, "get_currency: <" + to_string(precision) + "> <" + code + "> <" + contract + ">");
-
-  symbol currency_symbol = symbol(code, precision);
-  return extended_symbol(currency_symbol, name(contract));
+  return parse_currency(parameter_iterator->value);
 }
 
 
@@ -1004,9 +2771,7 @@ extended_symbol get_currency() {
  * @param p The power to raise x by
  */
 int intPower(int x, int p) {
-  if (p == 0) return 1;
-  if (p == 1) return x;
-  return x * intPower(x, p-1);
+  return cronacle_rules::int_power(x, p);
 }
 
 };
\ No newline at end of file
@@ -1,6 +1,11 @@
+#pragma once
+
 #include <eosio/eosio.hpp>
 #include <eosio/system.hpp>
 #include <eosio/asset.hpp>
+#include <eosio/crypto.hpp>
+
+#include "cronacle_dbtrace.hpp"
 
 using namespace eosio;
 using namespace std;
@@ -17,6 +22,49 @@ const name nft_account = name("atomicassets");
 // User contribution to Conditionally Limited Supply
 const asset UCLS = asset(1000000, POINT_CURRENCY_SYMBOL);
 
+// number of winners kept in the leaderboard
+const uint8_t LEADERBOARD_SIZE = 10;
+
+// number of recent bids kept for each auction
+const uint8_t BID_HISTORY_SLOTS = 16;
+
+// maximum number of pre-bids kept for each queued nft
+const uint8_t MAX_PREBIDS = 20;
+
+// maximum number of sealed bids held for the final bidding window of an auction
+const uint8_t MAX_SEALED_BIDS = 50;
+
+// number of recent bid nonces kept for each user
+const uint8_t BID_NONCE_SLOTS = 8;
+
+// outcomes of an accepted bid, kept with its nonce
+const uint8_t BID_PLACED = 1;
+const uint8_t BID_SEALED = 2;
+
+// maximum number of assets sold together in a bundle auction
+const uint8_t MAX_BUNDLE_SIZE = 10;
+
+// maximum number of rows in one importstate chunk
+const uint16_t MAX_IMPORT_ROWS = 100;
+
+// maximum number of accounts in one balances or allbalances report
+const uint16_t MAX_BALANCE_ROWS = 500;
+
+// maximum number of rows rewritten by one migrate action
+const uint16_t MIGRATE_BATCH_ROWS = 100;
+
+// memo prefix of a deposit to a custodian's sub-account, e.g. sub:1234
+const string SUBACCOUNT_MEMO_PREFIX = "sub:";
+
+// maximum number of sub-accounts in one subwithdraw action
+const uint16_t MAX_SUBACCOUNT_BATCH = 100;
+
+// maximum number of rows erased by one maintain action. Larger tables are cleared by repeating the action
+const uint16_t MAINTAIN_BATCH_ROWS = 200;
+
+// approximate RAM overhead billed by the chain for each table row, used to report reclaimed RAM
+const uint32_t ROW_OVERHEAD_BYTES = 112;
+
 
 // SYSTEM
 // system table
@@ -27,7 +75,7 @@ asset cls;
 
 uint64_t primary_key() const { return 0; } // return a constant to ensure a single-row table
 };
-using system_index = eosio::multi_index<"system"_n, system_record>;
+using system_index = cronacle_table<"system"_n, system_record>;
 
 
 // USERS
@@ -37,7 +85,36 @@ struct[[ eosio::table("users"), eosio::contract("cronacle") ]] user {
     std::string dfinity_principal;
 uint64_t primary_key() const { return proton_account.value; }
 };
-using users_index = eosio::multi_index<"users"_n, user>;
+using users_index = cronacle_table<"users"_n, user>;
+
+
+// ACTIVITY
+// candidates for garbage collection, oldest first in the byidle index. Updated by deposits, bids and withdrawals.
+// The gc action drops the record of an idle account that still holds credit; it re-enters on its next activity
+struct[[ eosio::table("activity"), eosio::contract("cronacle") ]] user_activity {
+    name        account;
+    time_point  last;
+
+    uint64_t primary_key() const { return account.value; }
+    uint64_t get_secondary() const { return last.time_since_epoch().count(); }
+};
+using activity_index = cronacle_table<"activity"_n, user_activity,
+indexed_by<"byidle"_n, const_mem_fun<user_activity, uint64_t, &user_activity::get_secondary>>>;
+
+
+// PRINCIPALS
+// global lookup of proton account by DFINITY principal. The byhash index is a 64-bit hash of the principal;
+// different principals may share a hash, so lookups compare the stored principal
+struct[[ eosio::table("principals"), eosio::contract("cronacle") ]] principal_link {
+    name        account;
+    std::string principal;
+    uint64_t    hash;
+
+    uint64_t primary_key() const { return account.value; }
+    uint64_t get_secondary() const { return hash; }
+};
+using principals_index = cronacle_table<"principals"_n, principal_link,
+indexed_by<"byhash"_n, const_mem_fun<principal_link, uint64_t, &principal_link::get_secondary>>>;
 
 
 // CREDITS
@@ -45,7 +122,7 @@ struct[[ eosio::table("credits"), eosio::contract("cronacle") ]] credit {
     asset amount;
     uint64_t primary_key() const { return 0; }  // ensures single record per user
 };
-using credits_index = eosio::multi_index<"credits"_n, credit>;
+using credits_index = cronacle_table<"credits"_n, credit>;
 
 
 // BIDS - contains top 3 bids
@@ -58,11 +135,78 @@ struct[[ eosio::table("bids"), eosio::contract("cronacle") ]] userbid {
     uint64_t primary_key() const { return bidder.value; }
     uint64_t get_secondary() const { return bidamount.amount; }
 };
-using bids_index = eosio::multi_index<"bids"_n, userbid,
+using bids_index = cronacle_table<"bids"_n, userbid,
 indexed_by<"byamount"_n, const_mem_fun<userbid, uint64_t, &userbid::get_secondary>>>;
 
 
-// AUCTIONS
+// PREBIDS - bids filed against a queued nft before its auction opens. Scope is the nftid
+struct[[ eosio::table("prebids"), eosio::contract("cronacle") ]] prebid_record {
+    time_point  bidtime;
+    name        bidder;
+    asset       bidamount;
+
+    uint64_t primary_key() const { return bidder.value; }
+    uint64_t get_secondary() const { return bidamount.amount; }
+};
+using prebids_index = cronacle_table<"prebids"_n, prebid_record,
+indexed_by<"byamount"_n, const_mem_fun<prebid_record, uint64_t, &prebid_record::get_secondary>>>;
+
+
+// SEALEDBIDS - bids placed in the final batchwindow seconds of the bidding period. They are not compared with
+// each other when placed, but cleared together when bidding ends. One bid per bidder; number is the auction
+struct[[ eosio::table("sealedbids"), eosio::contract("cronacle") ]] sealed_bid {
+    uint32_t    number;
+    time_point  bidtime;
+    name        bidder;
+    asset       bidamount;
+    uint64_t    nftid;
+
+    uint64_t primary_key() const { return bidder.value; }
+    uint64_t get_secondary() const { return bidamount.amount; }
+};
+using sealedbids_index = cronacle_table<"sealedbids"_n, sealed_bid,
+indexed_by<"byamount"_n, const_mem_fun<sealed_bid, uint64_t, &sealed_bid::get_secondary>>>;
+
+
+// BIDNONCES - the nonces of a user's most recent bids, held in a fixed-size ring buffer so that a resubmitted bid
+// is recognised with one lookup. head is the slot that the next nonce overwrites; unused slots have a 0 nonce.
+// Scope is the user's account
+struct nonce_slot {
+    uint64_t    nonce;
+    uint64_t    nftid;
+    asset       bidamount;
+    uint8_t     outcome;    // BID_PLACED or BID_SEALED
+};
+
+struct[[ eosio::table("bidnonces"), eosio::contract("cronacle") ]] bid_nonces {
+    uint8_t                 head;
+    std::vector<nonce_slot> slots;
+
+    uint64_t primary_key() const { return 0; }  // ensures single record per user
+};
+using bidnonces_index = cronacle_table<"bidnonces"_n, bid_nonces>;
+
+
+// BID HISTORY - the most recent BID_HISTORY_SLOTS bids of each auction, held in a fixed-size ring buffer.
+// head is the slot that the next bid overwrites; unused slots have an empty bidder
+struct bidslot {
+    name        bidder;
+    uint64_t    amount;
+    uint32_t    offset;   // seconds since the start of the auction
+};
+
+struct[[ eosio::table("bidhistory"), eosio::contract("cronacle") ]] bid_history {
+    uint32_t             number;
+    uint8_t              head;
+    std::vector<bidslot> slots;
+
+    uint64_t primary_key() const { return number; }
+};
+using bidhistory_index = cronacle_table<"bidhistory"_n, bid_history>;
+
+
+// AUCTIONS - the contract only reads the latest auction, so the table has no secondary index. A user's auctions
+// are in the wins table, written once when the auction is settled
 struct[[ eosio::table("auctions"), eosio::contract("cronacle") ]] auction {
     uint32_t    number;
     uint64_t    nftid;
@@ -76,22 +220,90 @@ struct[[ eosio::table("auctions"), eosio::contract("cronacle") ]] auction {
     uint64_t get_secondary() const { return nftid; }
     uint64_t get_tertiary() const { return winner.value; }
 };
-using auctions_index = eosio::multi_index<"auctions"_n, auction,
+using auctions_index = cronacle_table<"auctions"_n, auction>;
+
+// AUCTIONHEAD - the number and auctions table scope of the latest auction. With the seasonlen parameter each
+// season's auctions have their own scope, the season number; otherwise, and before 0.15.0, the scope is the
+// contract's. Auction numbers continue from one season to the next
+struct[[ eosio::table("auctionhead"), eosio::contract("cronacle") ]] auction_head {
+    uint32_t    number;
+    uint64_t    scope;
+
+    uint64_t primary_key() const { return 0; } // return a constant to ensure a single-row table
+};
+using auctionhead_index = cronacle_table<"auctionhead"_n, auction_head>;
+
+// the auctions table as written by contract versions before 0.14.0, with the bynftid and bywinner indexes.
+// Only used by the migrate action to remove the index entries of the rows those versions wrote
+using legacy_auctions_index = cronacle_table<"auctions"_n, auction,
 indexed_by<"bynftid"_n, const_mem_fun<auction, uint64_t, &auction::get_secondary>>,
 indexed_by<"bywinner"_n, const_mem_fun<auction, uint64_t, &auction::get_tertiary>>
 >;
 
-// NFTs for offer
+// WINS - the auctions won by a user. Scope is the winner's account
+struct[[ eosio::table("wins"), eosio::contract("cronacle") ]] auction_win {
+    uint32_t    number;
+    uint64_t    nftid;
+    time_point  end;
+    asset       bidamount;
+
+    uint64_t primary_key() const { return number; }
+};
+using wins_index = cronacle_table<"wins"_n, auction_win>;
+
+// WINSTATS - running totals of a user's wins. Scope is the winner's account
+struct[[ eosio::table("winstats"), eosio::contract("cronacle") ]] winstat {
+    uint32_t    wins;
+    asset       spend;
+
+    uint64_t primary_key() const { return 0; }  // ensures single record per user
+};
+using winstats_index = cronacle_table<"winstats"_n, winstat>;
+
+// LEADERBOARD - the top LEADERBOARD_SIZE winners by total spend, highest first
+struct leader {
+    name        account;
+    uint32_t    wins;
+    asset       spend;
+};
+
+struct[[ eosio::table("leaderboard"), eosio::contract("cronacle") ]] leaderboard_record {
+    std::vector<leader> leaders;
+
+    uint64_t primary_key() const { return 0; } // return a constant to ensure a single-row table
+};
+using leaderboard_index = cronacle_table<"leaderboard"_n, leaderboard_record>;
+
+// NFTs for offer. A bundle entry is auctioned as nftid and settled with the assets in bundle as well
 struct[[ eosio::table("nfts"), eosio::contract("cronacle") ]] nft {
     uint32_t    number;
     uint64_t    nftid;
-    
+    binary_extension<std::vector<uint64_t>> bundle;
+
     uint64_t primary_key() const { return number; }
     uint64_t get_secondary() const { return nftid; }
+
+    // the ids of all the assets sold in the entry's auction
+    std::vector<uint64_t> assets() const {
+      std::vector<uint64_t> ids = bundle.value_or();
+      ids.insert(ids.begin(), nftid);
+      return ids;
+    }
 };
-using nfts_index = eosio::multi_index<"nfts"_n, nft,
+using nfts_index = cronacle_table<"nfts"_n, nft,
 indexed_by<"bynftid"_n, const_mem_fun<nft, uint64_t, &nft::get_secondary>>>;
 
+// BUNDLE MEMBERS
+// the assets of queued bundles other than the entry's nftid, so that an nft in a bundle cannot be queued again.
+// Written when the bundle is queued and erased when the bundle leaves the queue; relisting keeps them
+struct[[ eosio::table("bundlenfts"), eosio::contract("cronacle") ]] bundle_member {
+    uint64_t    nftid;
+    uint64_t    head;        // the nftid of the bundle's queue entry
+
+    uint64_t primary_key() const { return nftid; }
+};
+using bundlenfts_index = cronacle_table<"bundlenfts"_n, bundle_member>;
+
 // PARAMETERS
 // parameters table
 struct[[ eosio::table("parameters"), eosio::contract("cronacle") ]] parameter {
@@ -100,7 +312,7 @@ string value;
 
 uint64_t primary_key() const { return paramname.value; }
 };
-using parameters_index = eosio::multi_index<"parameters"_n, parameter>;
+using parameters_index = cronacle_table<"parameters"_n, parameter>;
 
 // ADMIN WHITELIST
 // admin accounts table - a whitelist of which accounts can perform privileged actions: e.g. addnft and removenft
@@ -109,4 +321,117 @@ struct[[ eosio::table("admins"), eosio::contract("cronacle") ]] admin_whitelist
 
   uint64_t primary_key() const { return account.value; }
 };
-using admins_index = eosio::multi_index<"admins"_n, admin_whitelist>;
\ No newline at end of file
+using admins_index = cronacle_table<"admins"_n, admin_whitelist>;
+
+// PAYOUTS
+// pending withdrawals, used when the payoutqueue parameter is switched on. One record per user so that
+// repeated withdrawals are merged into a single transfer by the payout action
+struct[[ eosio::table("payouts"), eosio::contract("cronacle") ]] pending_payout {
+    name        user;
+    asset       amount;
+    time_point  requested;
+
+    uint64_t primary_key() const { return user.value; }
+};
+using payouts_index = cronacle_table<"payouts"_n, pending_payout>;
+
+// SUBACCOUNTS
+// balances of the end-users of a custodian, credited by deposits with a sub:<id> memo. Scope is the custodian's
+// account, whose credit record holds the sub-account balances as well as its own credit
+struct[[ eosio::table("subaccounts"), eosio::contract("cronacle") ]] subaccount {
+    uint64_t    id;
+    asset       amount;
+
+    uint64_t primary_key() const { return id; }
+};
+using subaccounts_index = cronacle_table<"subaccounts"_n, subaccount>;
+
+// CUSTODIANS
+// held is the sum of a custodian's sub-account balances. The custodian's bid was placed for bid_subaccount if
+// it is still for bid_nftid and bid_amount; a bid placed by the custodian itself has a different amount
+struct[[ eosio::table("custodians"), eosio::contract("cronacle") ]] custodian_record {
+    name        account;
+    asset       held;
+    uint64_t    bid_subaccount;   // 0 if no bid has been placed for a sub-account
+    uint64_t    bid_nftid;
+    asset       bid_amount;
+
+    uint64_t primary_key() const { return account.value; }
+
+    bool bid_for_subaccount(const userbid &b) const {
+      return bid_subaccount != 0 && b.bidder == account && b.nftid == bid_nftid && b.bidamount == bid_amount;
+    }
+};
+using custodians_index = cronacle_table<"custodians"_n, custodian_record>;
+
+// HOLDERS
+// the accounts that have a credit record, so that the balances of all users can be listed. Kept in step with the
+// credits table by action_context::flush. The totals count the credit of these accounts only
+struct[[ eosio::table("holders"), eosio::contract("cronacle") ]] holder {
+    name        account;
+
+    uint64_t primary_key() const { return account.value; }
+};
+using holders_index = cronacle_table<"holders"_n, holder>;
+
+// TOTALS
+// the sums of all credit balances and of all queued payouts, i.e. what the contract owes its users
+struct[[ eosio::table("totals"), eosio::contract("cronacle") ]] totals_record {
+    asset       credit;
+    asset       queued;
+
+    uint64_t primary_key() const { return 0; } // return a constant to ensure a single-row table
+};
+using totals_index = cronacle_table<"totals"_n, totals_record>;
+
+
+// SNAPSHOT ROWS
+// row formats of the chunks loaded by the importstate action. Rows of the tables that are scoped by user carry
+// the account, and auction rows carry their scope, 0 for the contract's. The auctionhead, parameters, admins,
+// custodians and system chunks use the table structs themselves; an auctionhead scope of 0 is also the contract's
+struct user_snapshot {
+    name        account;
+    time_point  time;
+    std::string dfinity_principal;
+};
+
+struct credit_snapshot {
+    name        account;
+    asset       amount;
+};
+
+struct nft_snapshot {
+    uint32_t    number;
+    uint64_t    nftid;
+    std::vector<uint64_t> bundle;
+};
+
+struct auction_snapshot {
+    uint64_t    scope;       // a season number, or 0 for the contract's scope
+    auction     record;
+};
+
+struct subaccount_snapshot {
+    name        custodian;
+    uint64_t    id;
+    asset       amount;
+};
+
+
+// BALANCE REPORTS
+// returned by the balances and allbalances actions
+struct account_balance {
+    name        account;
+    asset       credit;      // total credit
+    asset       locked;      // the user's winning bid in the current auction
+    asset       held;        // the balances of a custodian's sub-accounts
+    asset       available;   // credit that can be bid or withdrawn
+    asset       queued;      // withdrawn credit waiting for the payout action
+};
+
+struct balance_report {
+    std::vector<account_balance> balances;
+    asset       total_credit;
+    asset       total_queued;
+    name        next;        // allbalances cursor for the next page, empty after the last page
+};
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <eosio/eosio.hpp>
+#include <eosio/system.hpp>
+#include <eosio/asset.hpp>
+#include <stdio.h>
+#include <map>
+#include <memory>
+
+#include "cronacle.hpp"
+
+using namespace eosio;
+using namespace std;
+
+
+/**
+ * parse_currency function parses the value of the 'currency' parameter
+ *
+ * @param value the parameter value. The format is precision code contract e.g. 4 FREEOS freeostokens
+ * @return An extended_symbol representing the currency
+ */
+inline extended_symbol parse_currency(const string &value) {
+  char code[13];
+  int precision;
+  char contract[13];
+
+  sscanf(value.c_str(), "%d %12s %12s", &precision, code, contract);
+
+  return extended_symbol(symbol(code, precision), name(contract));
+}
+
+
+/**
+ * action_context holds the state that the helpers of one action share. Each table with the contract's scope is
+ * opened once, and the clock, currency, parameters, system record, latest auction and credit balances are read
+ * at most once. Changes to the system record and credit balances are kept in the context and written back by
+ * flush(), once per row, at the end of the action. flush() also keeps the holders table and the totals record
+ * in step with the credit balances.
+ */
+class action_context {
+
+  struct cached_credit {
+    std::unique_ptr<credits_index> table;
+    const credit *row;   // the stored row, nullptr if the user has no credit record
+    asset amount;
+    bool  exists;        // the row exists after this action
+    bool  dirty;
+  };
+
+  name self;
+
+  bool now_loaded = false;
+  time_point now_value;
+
+  bool currency_loaded = false;
+  extended_symbol currency_value;
+
+  std::map<uint64_t, string> parameter_values;
+  std::map<uint64_t, bool> parameter_loaded;
+
+  bool system_loaded = false;
+  bool system_dirty = false;
+  const system_record *system_row = nullptr;
+  system_record system_value;
+
+  std::map<uint64_t, cached_credit> credit_values;
+
+  // the auctions table scope that holds the latest auction, and the latest auction record
+  bool latest_loaded = false;
+  std::unique_ptr<auctions_index> latest_table;
+  const auction *latest_row = nullptr;
+
+  int64_t credit_total_delta = 0;
+  int64_t queued_total_delta = 0;
+
+public:
+  parameters_index parameters_table;
+  system_index     system_table;
+  bids_index       bids_table;
+  auctionhead_index auctionhead_table;
+  nfts_index       nfts_table;
+  payouts_index    payouts_table;
+  activity_index   activity_table;
+  holders_index    holders_table;
+  totals_index     totals_table;
+
+  action_context(name contract) :
+    self(contract),
+    parameters_table(contract, contract.value),
+    system_table(contract, contract.value),
+    bids_table(contract, contract.value),
+    auctionhead_table(contract, contract.value),
+    nfts_table(contract, contract.value),
+    payouts_table(contract, contract.value),
+    activity_table(contract, contract.value),
+    holders_table(contract, contract.value),
+    totals_table(contract, contract.value) {}
+
+  name get_self() const { return self; }
+
+  time_point now() {
+    if (!now_loaded) {
+      now_value = current_time_point();
+      now_loaded = true;
+    }
+    return now_value;
+  }
+
+  extended_symbol currency() {
+    if (!currency_loaded) {
+      currency_value = parse_currency(parameter("currency"_n, "currency parameter is not defined"));
+      currency_loaded = true;
+    }
+    return currency_value;
+  }
+
+  asset zero() {
+    return asset(0, currency().get_symbol());
+  }
+
+  // returns true if the parameter is defined
+  bool has_parameter(name paramname) {
+    auto loaded_itr = parameter_loaded.find(paramname.value);
+    if (loaded_itr != parameter_loaded.end()) return loaded_itr->second;
+
+    auto parameter_iterator = parameters_table.find(paramname.value);
+    bool defined = (parameter_iterator != parameters_table.end());
+    if (defined) {
+      parameter_values[paramname.value] = parameter_iterator->value;
+    }
+    parameter_loaded[paramname.value] = defined;
+
+    return defined;
+  }
+
+  // returns the value of a parameter that must be defined
+  const string &parameter(name paramname, const char *undefined_msg) {
+    check(has_parameter(paramname), undefined_msg);
+    return parameter_values[paramname.value];
+  }
+
+  // returns true if an on/off parameter is defined and is not "0"
+  bool enabled(name paramname) {
+    return has_parameter(paramname) && parameter_values[paramname.value] != "0";
+  }
+
+  bool has_system() {
+    if (!system_loaded) {
+      auto system_iterator = system_table.begin();
+      if (system_iterator != system_table.end()) {
+        system_row = &*system_iterator;
+        system_value = *system_row;
+      }
+      system_loaded = true;
+    }
+    return system_row != nullptr || system_dirty;
+  }
+
+  const system_record &system() {
+    check(has_system(), "the system record is undefined");
+    return system_value;
+  }
+
+  // applies a change to the system record, creating the record if it is undefined
+  template<typename Lambda>
+  void update_system(Lambda &&updater) {
+    has_system();
+    updater(system_value);
+    system_dirty = true;
+  }
+
+  // returns the latest auction record, nullptr if there has been no auction
+  const auction *latest_auction() {
+    if (!latest_loaded) {
+      // auctions written before the auction head existed are in the contract's scope
+      uint64_t scope = self.value;
+      auto head_iterator = auctionhead_table.begin();
+      if (head_iterator != auctionhead_table.end()) {
+        scope = head_iterator->scope;
+      }
+
+      latest_table = std::make_unique<auctions_index>(self, scope);
+      auto auction_iterator = latest_table->rbegin();
+      latest_row = (auction_iterator != latest_table->rend()) ? &*auction_iterator : nullptr;
+      latest_loaded = true;
+    }
+    return latest_row;
+  }
+
+  // returns the number of the latest auction that has been opened, which the auction head keeps when the
+  // auctions table is cleared; 0 if there has been no auction
+  uint32_t last_auction_number() {
+    auto head_iterator = auctionhead_table.begin();
+    if (head_iterator != auctionhead_table.end()) {
+      return head_iterator->number;
+    }
+    const auction *latest = latest_auction();
+    return (latest != nullptr) ? latest->number : 0;
+  }
+
+  // writes a new auction record, which becomes the latest auction, into the given scope of the auctions table
+  template<typename Lambda>
+  void open_auction(uint64_t scope, Lambda &&constructor) {
+    latest_auction();
+    if (latest_table->get_scope() != scope) {
+      latest_table = std::make_unique<auctions_index>(self, scope);
+    }
+    latest_row = &*latest_table->emplace(self, constructor);
+
+    auto head_iterator = auctionhead_table.begin();
+    if (head_iterator == auctionhead_table.end()) {
+      auctionhead_table.emplace(self, [&](auto &h) {
+        h.number = latest_row->number;
+        h.scope = scope;
+      });
+    } else if (head_iterator->number != latest_row->number || head_iterator->scope != scope) {
+      auctionhead_table.modify(head_iterator, self, [&](auto &h) {
+        h.number = latest_row->number;
+        h.scope = scope;
+      });
+    }
+  }
+
+  // applies a change to the latest auction record, which must exist
+  template<typename Lambda>
+  void update_latest_auction(Lambda &&updater) {
+    check(latest_auction() != nullptr, "auction record is undefined");
+    latest_table->modify(*latest_row, self, updater);
+  }
+
+  // returns the user's total credit, zero if the user has no credit record
+  asset credit(name user) {
+    return load_credit(user).amount;
+  }
+
+  bool has_credit_record(name user) {
+    return load_credit(user).exists;
+  }
+
+  // sets the user's total credit, creating the credit record if necessary
+  void set_credit(name user, asset amount) {
+    cached_credit &c = load_credit(user);
+    c.amount = amount;
+    c.exists = true;
+    c.dirty = true;
+  }
+
+  void erase_credit(name user) {
+    cached_credit &c = load_credit(user);
+    c.amount = zero();
+    c.exists = false;
+    c.dirty = true;
+  }
+
+  // adds to the totals of credit and queued payouts, for changes that are not made through set_credit
+  void adjust_totals(asset credit, asset queued) {
+    credit_total_delta += credit.amount;
+    queued_total_delta += queued.amount;
+  }
+
+  /**
+   * flush function writes the modified system record and credit records back to their tables.
+   * Rows read by the action are updated through the loaded objects, without looking them up again.
+   */
+  void flush() {
+    if (system_dirty) {
+      if (system_row == nullptr) {
+        system_row = &*system_table.emplace(self, [&](auto &sys) { sys = system_value; });
+      } else {
+        system_table.modify(*system_row, self, [&](auto &sys) { sys = system_value; });
+      }
+      system_dirty = false;
+    }
+
+    for (auto &entry : credit_values) {
+      cached_credit &c = entry.second;
+      if (!c.dirty) continue;
+
+      // a credit row written before the holders table existed is not counted in the totals. Its first write
+      // tracks it and counts the whole new amount, and erasing it takes nothing off the totals
+      auto holder_iterator = holders_table.find(entry.first);
+      bool tracked = holder_iterator != holders_table.end();
+      int64_t stored_amount = (c.row != nullptr && tracked) ? c.row->amount.amount : 0;
+      credit_total_delta += (c.exists ? c.amount.amount : 0) - stored_amount;
+
+      if (!c.exists) {
+        if (c.row != nullptr) {
+          c.table->erase(*c.row);
+          c.row = nullptr;
+          if (tracked) holders_table.erase(holder_iterator);
+        }
+      } else {
+        if (c.row != nullptr) {
+          c.table->modify(*c.row, self, [&](auto &cr) { cr.amount = c.amount; });
+        } else {
+          c.row = &*c.table->emplace(self, [&](auto &cr) { cr.amount = c.amount; });
+        }
+        if (!tracked) {
+          holders_table.emplace(self, [&](auto &h) { h.account = name(entry.first); });
+        }
+      }
+      c.dirty = false;
+    }
+
+    if (credit_total_delta != 0 || queued_total_delta != 0) {
+      symbol currency_symbol = currency().get_symbol();
+      auto totals_iterator = totals_table.begin();
+
+      if (totals_iterator == totals_table.end()) {
+        totals_table.emplace(self, [&](auto &t) {
+          t.credit = asset(credit_total_delta, currency_symbol);
+          t.queued = asset(queued_total_delta, currency_symbol);
+        });
+      } else {
+        totals_table.modify(totals_iterator, self, [&](auto &t) {
+          t.credit.amount += credit_total_delta;
+          t.queued.amount += queued_total_delta;
+        });
+      }
+      credit_total_delta = 0;
+      queued_total_delta = 0;
+    }
+  }
+
+private:
+
+  cached_credit &load_credit(name user) {
+    auto cached_itr = credit_values.find(user.value);
+    if (cached_itr != credit_values.end()) return cached_itr->second;
+
+    cached_credit &c = credit_values[user.value];
+    c.table = std::make_unique<credits_index>(self, user.value);
+
+    auto credit_iterator = c.table->begin();
+    c.row = (credit_iterator != c.table->end()) ? &*credit_iterator : nullptr;
+    c.amount = (c.row != nullptr) ? c.row->amount : zero();
+    c.exists = (c.row != nullptr);
+    c.dirty = false;
+
+    return c;
+  }
+};
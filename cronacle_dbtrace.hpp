@@ -0,0 +1,191 @@
+#pragma once
+
+#include <eosio/eosio.hpp>
+#include <map>
+#include <iterator>
+
+// Database-operation tracing.
+// Building with -DCRONACLE_DBTRACE replaces the contract's multi_index tables with wrappers that count every
+// table operation. When the action returns, the contract prints one line of JSON with the counts per table:
+//
+//   DBTRACE {"bids":{"find":1,"begin":2,"next":4,"emplace":1,"modify":0,"erase":0,"idx":2,"idx_find":0,
+//            "idx_begin":1,"idx_next":1,"idx_modify":0,"idx_erase":0,"bytes":44},...}
+//
+// next counts iterator steps in either direction (including the step taken to dereference a reverse iterator),
+// idx_* count operations on secondary indexes and bytes is the serialized size of the rows written.
+// Without the flag cronacle_table is eosio::multi_index and nothing is counted.
+
+using namespace eosio;
+
+#ifdef CRONACLE_DBTRACE
+
+struct dbtrace_counts {
+  uint32_t find = 0;
+  uint32_t begin = 0;
+  uint32_t next = 0;
+  uint32_t emplace = 0;
+  uint32_t modify = 0;
+  uint32_t erase = 0;
+  uint32_t idx = 0;
+  uint32_t idx_find = 0;
+  uint32_t idx_begin = 0;
+  uint32_t idx_next = 0;
+  uint32_t idx_modify = 0;
+  uint32_t idx_erase = 0;
+  uint64_t bytes = 0;
+};
+
+// counts for the current action, keyed by table name
+inline std::map<uint64_t, dbtrace_counts> &dbtrace_profile() {
+  static std::map<uint64_t, dbtrace_counts> profile;
+  return profile;
+}
+
+inline dbtrace_counts &dbtrace_table(name table) {
+  return dbtrace_profile()[table.value];
+}
+
+/**
+ * dbtrace_report function prints the counts for the current action and resets them
+ */
+inline void dbtrace_report() {
+  std::string report = "DBTRACE {";
+  bool first = true;
+
+  for (const auto &entry : dbtrace_profile()) {
+    const dbtrace_counts &c = entry.second;
+    report += (first ? "\"" : ",\"") + name(entry.first).to_string() + "\":{"
+      + "\"find\":" + std::to_string(c.find)
+      + ",\"begin\":" + std::to_string(c.begin)
+      + ",\"next\":" + std::to_string(c.next)
+      + ",\"emplace\":" + std::to_string(c.emplace)
+      + ",\"modify\":" + std::to_string(c.modify)
+      + ",\"erase\":" + std::to_string(c.erase)
+      + ",\"idx\":" + std::to_string(c.idx)
+      + ",\"idx_find\":" + std::to_string(c.idx_find)
+      + ",\"idx_begin\":" + std::to_string(c.idx_begin)
+      + ",\"idx_next\":" + std::to_string(c.idx_next)
+      + ",\"idx_modify\":" + std::to_string(c.idx_modify)
+      + ",\"idx_erase\":" + std::to_string(c.idx_erase)
+      + ",\"bytes\":" + std::to_string(c.bytes) + "}";
+    first = false;
+  }
+
+  report += "}\n";
+  print(report);
+  dbtrace_profile().clear();
+}
+
+// iterator that counts its steps in one of the counters of a table
+template<typename Iterator>
+struct traced_iterator : public Iterator {
+  dbtrace_counts *counts = nullptr;
+  uint32_t dbtrace_counts::*steps = nullptr;
+
+  traced_iterator() = default;
+  traced_iterator(const Iterator &itr, dbtrace_counts *c, uint32_t dbtrace_counts::*s) : Iterator(itr), counts(c), steps(s) {}
+
+  traced_iterator &operator++() { (counts->*steps)++; Iterator::operator++(); return *this; }
+  traced_iterator &operator--() { (counts->*steps)++; Iterator::operator--(); return *this; }
+  traced_iterator operator++(int) { traced_iterator previous = *this; ++(*this); return previous; }
+  traced_iterator operator--(int) { traced_iterator previous = *this; --(*this); return previous; }
+};
+
+// secondary index that counts its operations
+template<typename Index>
+class traced_secondary_index : public Index {
+  dbtrace_counts *counts;
+
+public:
+  using const_iterator = traced_iterator<typename Index::const_iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  traced_secondary_index(const Index &idx, dbtrace_counts *c) : Index(idx), counts(c) {}
+
+  const_iterator wrap(const typename Index::const_iterator &itr) const { return const_iterator(itr, counts, &dbtrace_counts::idx_next); }
+
+  const_iterator begin() const { counts->idx_begin++; return wrap(Index::begin()); }
+  const_iterator end() const { return wrap(Index::end()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  template<typename Key> const_iterator find(const Key &key) const { counts->idx_find++; return wrap(Index::find(key)); }
+  template<typename Key> const_iterator lower_bound(const Key &key) const { counts->idx_find++; return wrap(Index::lower_bound(key)); }
+  template<typename Key> const_iterator upper_bound(const Key &key) const { counts->idx_find++; return wrap(Index::upper_bound(key)); }
+
+  template<typename Lambda>
+  void modify(const typename Index::const_iterator &itr, name payer, Lambda &&updater) {
+    counts->idx_modify++;
+    Index::modify(itr, payer, std::forward<Lambda>(updater));
+    counts->bytes += pack_size(*itr);
+  }
+
+  const_iterator erase(const typename Index::const_iterator &itr) { counts->idx_erase++; return wrap(Index::erase(itr)); }
+};
+
+// multi_index that counts its operations
+template<name::raw TableName, typename T, typename... Indices>
+class traced_multi_index : public eosio::multi_index<TableName, T, Indices...> {
+  using base = eosio::multi_index<TableName, T, Indices...>;
+
+  dbtrace_counts &counts() const { return dbtrace_table(name(TableName)); }
+
+public:
+  using const_iterator = traced_iterator<typename base::const_iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  traced_multi_index(name code, uint64_t scope) : base(code, scope) {}
+
+  const_iterator wrap(const typename base::const_iterator &itr) const { return const_iterator(itr, &counts(), &dbtrace_counts::next); }
+
+  const_iterator begin() const { counts().begin++; return wrap(base::begin()); }
+  const_iterator end() const { return wrap(base::end()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  const_iterator find(uint64_t primary) const { counts().find++; return wrap(base::find(primary)); }
+  const_iterator lower_bound(uint64_t primary) const { counts().find++; return wrap(base::lower_bound(primary)); }
+  const_iterator upper_bound(uint64_t primary) const { counts().find++; return wrap(base::upper_bound(primary)); }
+
+  template<typename Lambda>
+  const_iterator emplace(name payer, Lambda &&constructor) {
+    counts().emplace++;
+    auto itr = base::emplace(payer, std::forward<Lambda>(constructor));
+    counts().bytes += pack_size(*itr);
+    return wrap(itr);
+  }
+
+  template<typename Lambda>
+  void modify(const typename base::const_iterator &itr, name payer, Lambda &&updater) {
+    counts().modify++;
+    base::modify(itr, payer, std::forward<Lambda>(updater));
+    counts().bytes += pack_size(*itr);
+  }
+
+  template<typename Lambda>
+  void modify(const T &obj, name payer, Lambda &&updater) {
+    counts().modify++;
+    base::modify(obj, payer, std::forward<Lambda>(updater));
+    counts().bytes += pack_size(obj);
+  }
+
+  const_iterator erase(const typename base::const_iterator &itr) { counts().erase++; return wrap(base::erase(itr)); }
+  void erase(const T &obj) { counts().erase++; base::erase(obj); }
+
+  template<name::raw IndexName>
+  auto get_index() {
+    counts().idx++;
+    auto idx = base::template get_index<IndexName>();
+    return traced_secondary_index<decltype(idx)>(idx, &counts());
+  }
+};
+
+template<name::raw TableName, typename T, typename... Indices>
+using cronacle_table = traced_multi_index<TableName, T, Indices...>;
+
+#else
+
+template<name::raw TableName, typename T, typename... Indices>
+using cronacle_table = eosio::multi_index<TableName, T, Indices...>;
+
+#endif
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <stdint.h>
+
+// Auction rules shared by the cronacle contract and native clients.
+// The functions are pure and constexpr and depend only on the standard integer types, so the header also
+// compiles natively. Times are seconds since the epoch unless stated otherwise; amounts are in the smallest
+// unit of the credit currency.
+
+namespace cronacle_rules {
+
+// the auction slot that contains a moment in time
+struct auction_window {
+  uint64_t start_secs;
+  uint64_t bidding_end_secs;
+  uint64_t end_ms;        // milliseconds since the epoch, 1 millisecond before the next possible auction
+  bool     bidding_open;  // false if the moment is in the cooldown period after bidding
+};
+
+// the latest auction record, as far as the bid routing rule is concerned. Times are microseconds since the epoch
+struct latest_auction {
+  bool     exists;
+  uint64_t nftid;
+  int64_t  start_us;
+  int64_t  bidding_end_us;
+  int64_t  end_us;
+};
+
+// what the bid action does with a bid
+enum class bid_route {
+  not_offered,      // the nft is not open for bidding
+  bidding_ended,    // the nft's auction is past its bidding period
+  add_bid,          // add the bid to the current auction
+  open_first,       // create the auction for the first nft, then add the bid
+  close_and_open,   // close the first nft's auction, create the auction for the second nft, then add the bid
+  close_and_reopen  // close the auction of the only nft in the queue; if it was unsold and relisted, create its
+                    // next auction, then add the bid
+};
+
+
+/**
+ * window_at function returns the auction slot containing a moment. Slots repeat every auction_length
+ * seconds from init_secs, and bidding is open for the first bidding_period seconds of each slot.
+ *
+ * @param init_secs the start of the first auction
+ * @param now_secs the moment, no earlier than init_secs
+ * @param auction_length the auctperiod parameter
+ * @param bidding_period the bidperiod parameter
+ */
+constexpr auction_window window_at(uint64_t init_secs, uint64_t now_secs, uint32_t auction_length, uint32_t bidding_period) {
+  uint64_t elapsed_secs = (now_secs - init_secs) % auction_length;
+  uint64_t start_secs = now_secs - elapsed_secs;
+
+  return auction_window{
+    start_secs,
+    start_secs + bidding_period,
+    ((start_secs + auction_length) * 1000) - 1,
+    elapsed_secs <= bidding_period
+  };
+}
+
+
+/**
+ * next_window_start function returns the start of the first slot that begins after a moment
+ *
+ * @param init_secs the start of the first auction
+ * @param now_secs the moment, no earlier than init_secs
+ * @param auction_length the auctperiod parameter
+ */
+constexpr uint64_t next_window_start(uint64_t init_secs, uint64_t now_secs, uint32_t auction_length) {
+  return now_secs - ((now_secs - init_secs) % auction_length) + auction_length;
+}
+
+
+/**
+ * season_at function returns the number of the season that contains a moment. Seasons are season_length
+ * seconds long and are numbered from 1, the season that starts at init_secs.
+ *
+ * @param init_secs the start of the first auction
+ * @param now_secs the moment, no earlier than init_secs
+ * @param season_length the seasonlen parameter
+ */
+constexpr uint64_t season_at(uint64_t init_secs, uint64_t now_secs, uint32_t season_length) {
+  return (now_secs - init_secs) / season_length + 1;
+}
+
+
+/**
+ * minimum_next_bid function returns the lowest acceptable bid. The first bid must be at least
+ * minimum_bid; later bids must beat the highest bid by at least bidstep.
+ *
+ * @param bid_to_beat the highest bid, 0 if there is none
+ * @param minimum_bid the minimumbid parameter in currency units
+ * @param bidstep the bidstep parameter in currency units
+ */
+constexpr int64_t minimum_next_bid(int64_t bid_to_beat, int64_t minimum_bid, int64_t bidstep) {
+  return (bid_to_beat == 0) ? minimum_bid : bid_to_beat + bidstep;
+}
+
+
+/**
+ * route_bid function decides how a bid on nft_id is handled. Bids are accepted on the first nft in the
+ * queue while its auction is open, or on the second nft once the first nft's auction has ended. A bid on
+ * the only nft in the queue after its auction period closes that auction, which relists the nft if it was unsold.
+ *
+ * @param nft_id the nft being bid on
+ * @param first_nft the first nft in the queue
+ * @param second_nft the second nft in the queue, 0 if there is none
+ * @param latest the latest auction record
+ * @param now_us the time of the bid in microseconds since the epoch
+ */
+constexpr bid_route route_bid(uint64_t nft_id, uint64_t first_nft, uint64_t second_nft, latest_auction latest, int64_t now_us) {
+  if (nft_id != first_nft && nft_id != second_nft) return bid_route::not_offered;
+
+  if (latest.exists && latest.nftid == nft_id) {
+    if (now_us >= latest.start_us && now_us <= latest.bidding_end_us) return bid_route::add_bid;
+
+    // with no second nft, nothing else closes the auction of an nft that ended unsold
+    bool only_nft_over = nft_id == first_nft && second_nft == 0 && now_us > latest.end_us;
+    return only_nft_over ? bid_route::close_and_reopen : bid_route::bidding_ended;
+  }
+
+  if (nft_id == first_nft) return bid_route::open_first;
+
+  // the bid is for the second nft, which is only open once the whole auction period of the first nft is over
+  if (!latest.exists) return bid_route::not_offered;
+  bool first_auction_ongoing = latest.nftid == first_nft && now_us >= latest.start_us && now_us <= latest.end_us;
+
+  return first_auction_ongoing ? bid_route::not_offered : bid_route::close_and_open;
+}
+
+
+/**
+ * int_power function calculates x to the power p
+ */
+constexpr int64_t int_power(int64_t x, int p) {
+  return (p == 0) ? 1 : x * int_power(x, p - 1);
+}
+
+} // namespace cronacle_rules
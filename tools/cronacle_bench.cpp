@@ -0,0 +1,157 @@
+// cronacle_bench measures what each write to the auctions table costs with the table's current layout,
+// auctions_index, and with the layout of contract versions before 0.14.0, legacy_auctions_index, which also
+// kept the bynftid and bywinner indexes.
+//
+// Build:  g++ -std=c++17 -O2 -Wno-attributes -Itools/native -o cronacle_bench tools/cronacle_bench.cpp
+// Usage:  cronacle_bench [--rows N] [--repeat N]
+//
+//   --rows N     auctions written, settled and erased in a run   (default 1000)
+//   --repeat N   runs, of which the fastest is reported          (default 5)
+//
+// The contract's table definitions are compiled in over the native host in tools/native. The three writes the
+// contract makes to an auction are measured: the emplace when it opens, the find and modify that record the
+// winner when it is settled, and the find and erase when maintain clears the table. For each write the
+// benchmark prints the database intrinsics the CDT calls, of which the index writes are a part, the RAM billed
+// to the contract, and the time the write takes natively, which shows the relative cost of the index work but
+// not the chain's CPU time.
+
+#include "../cronacle.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+using namespace eosio;
+
+const name SELF = "cronacle"_n;
+
+// the cost of one kind of write, summed over the rows
+struct write_cost {
+  uint64_t intrinsics = 0;
+  uint64_t idx_writes = 0;
+  int64_t  ram = 0;
+  double   nanoseconds = 0;
+};
+
+struct layout_cost {
+  write_cost open;
+  write_cost settle;
+  write_cost erase;
+};
+
+
+// runs one write in its own action and adds its cost
+template<typename F>
+void measure(write_cost &cost, F &&write) {
+  native::host_state &host = native::host();
+  host.begin_action({SELF});
+  int64_t ram_before = host.ram_of(SELF);
+
+  auto start = std::chrono::steady_clock::now();
+  write();
+  auto stop = std::chrono::steady_clock::now();
+
+  cost.intrinsics += host.intrinsics.total();
+  cost.idx_writes += host.intrinsics.idx_writes;
+  cost.ram += host.ram_of(SELF) - ram_before;
+  cost.nanoseconds += std::chrono::duration<double, std::nano>(stop - start).count();
+  host.commit();
+}
+
+template<typename Table>
+layout_cost run(uint32_t rows) {
+  native::host().reset();
+  native::host().now_us = int64_t(1000000) * 1000000;
+  layout_cost cost;
+
+  for (uint32_t number = 1; number <= rows; number++) {
+    measure(cost.open, [&] {
+      Table auctions_table(SELF, SELF.value);
+      auctions_table.emplace(SELF, [&](auto &a) {
+        a.number = number;
+        a.nftid = 1000 + number;
+        a.start = time_point(seconds(1000000 + number * 3600));
+        a.bidding_end = time_point(seconds(1000000 + number * 3600 + 1800));
+        a.end = time_point(milliseconds((1000000 + int64_t(number + 1) * 3600) * 1000 - 1));
+      });
+    });
+  }
+
+  for (uint32_t number = 1; number <= rows; number++) {
+    measure(cost.settle, [&] {
+      Table auctions_table(SELF, SELF.value);
+      auto auction_itr = auctions_table.find(number);
+      auctions_table.modify(auction_itr, SELF, [&](auto &a) {
+        a.winner = name("user" + std::string(1, char('a' + number % 26)));
+        a.bidamount = asset(int64_t(number) * 10000, symbol("FREEOS", 4));
+      });
+    });
+  }
+
+  for (uint32_t number = 1; number <= rows; number++) {
+    measure(cost.erase, [&] {
+      Table auctions_table(SELF, SELF.value);
+      auctions_table.erase(auctions_table.find(number));
+    });
+  }
+
+  return cost;
+}
+
+// the fastest of the runs; the counts and RAM are the same in every run
+template<typename Table>
+layout_cost fastest(uint32_t rows, int repeat) {
+  layout_cost best = run<Table>(rows);
+  for (int i = 1; i < repeat; i++) {
+    layout_cost next = run<Table>(rows);
+    best.open.nanoseconds = std::min(best.open.nanoseconds, next.open.nanoseconds);
+    best.settle.nanoseconds = std::min(best.settle.nanoseconds, next.settle.nanoseconds);
+    best.erase.nanoseconds = std::min(best.erase.nanoseconds, next.erase.nanoseconds);
+  }
+  return best;
+}
+
+void print_write(const char *write, const write_cost &current, const write_cost &legacy, uint32_t rows) {
+  double n = rows;
+  std::printf("%-8s %10.2f %10.2f %10.2f %10.2f %10.1f %10.1f %10.0f %10.0f\n", write, double(current.intrinsics) / n,
+    double(legacy.intrinsics) / n, double(current.idx_writes) / n, double(legacy.idx_writes) / n,
+    double(current.ram) / n, double(legacy.ram) / n, current.nanoseconds / n, legacy.nanoseconds / n);
+}
+
+
+int usage() {
+  std::cerr << "usage: cronacle_bench [--rows N] [--repeat N]\n";
+  return 2;
+}
+
+
+int main(int argc, char **argv) {
+  uint32_t rows = 1000;
+  int repeat = 5;
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      if (i + 1 >= argc) return usage();
+      std::string value = argv[++i];
+
+      if (arg == "--rows") rows = uint32_t(std::stoul(value));
+      else if (arg == "--repeat") repeat = std::stoi(value);
+      else return usage();
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "invalid option: " << e.what() << "\n";
+    return usage();
+  }
+  if (rows == 0 || repeat <= 0) return usage();
+
+  layout_cost current = fastest<auctions_index>(rows, repeat);
+  layout_cost legacy = fastest<legacy_auctions_index>(rows, repeat);
+
+  std::printf("per write, over %u auctions: auctions_index, then legacy_auctions_index\n", rows);
+  std::printf("%-8s %21s %21s %21s %21s\n", "", "intrinsics", "index writes", "RAM bytes", "native ns");
+  print_write("open", current.open, legacy.open, rows);
+  print_write("settle", current.settle, legacy.settle, rows);
+  print_write("erase", current.erase, legacy.erase, rows);
+  return 0;
+}
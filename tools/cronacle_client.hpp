@@ -0,0 +1,819 @@
+#pragma once
+
+// Native client for the cronacle tables.
+//
+// Table rows are requested from a node's /v1/chain/get_table_rows endpoint with "json": false and decoded from
+// their binary form, so no JSON library or ABI lookup is needed on the client. Queries are pipelined: a batch
+// of requests is written to one keep-alive connection before the responses are read back, so reading the
+// credits of many users costs one round trip rather than one per user. Auctions that have been settled never
+// change, so the client keeps them and only asks the node for the auctions it does not hold. Auctions are read from the scope of
+// each season, newest first, as far back as needed, with the queries for several scopes in one batch.
+//
+// The row structs mirror cronacle.hpp and must be kept in step with it. The header needs C++17 and POSIX sockets.
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cronacle_client {
+
+// ROW TYPES
+
+struct asset {
+  int64_t  amount = 0;
+  uint64_t symbol = 0;   // precision in the low byte, code above it
+
+  uint8_t precision() const { return uint8_t(symbol & 0xff); }
+
+  std::string code() const {
+    std::string code;
+    for (uint64_t s = symbol >> 8; s != 0; s >>= 8) code += char(s & 0xff);
+    return code;
+  }
+
+  std::string to_string() const {
+    std::string digits = std::to_string(amount < 0 ? -amount : amount);
+    uint8_t p = precision();
+    if (p > 0) {
+      if (digits.size() <= p) digits.insert(0, p + 1 - digits.size(), '0');
+      digits.insert(digits.size() - p, ".");
+    }
+    return (amount < 0 ? "-" : "") + digits + " " + code();
+  }
+};
+
+struct credit_row {
+  asset    amount;
+};
+
+struct bid_row {
+  int64_t  bidtime;       // microseconds since the epoch
+  uint64_t bidder;
+  asset    bidamount;
+  uint64_t nftid;
+};
+
+struct auction_row {
+  uint32_t number;
+  uint64_t nftid;
+  int64_t  start;         // microseconds since the epoch
+  int64_t  bidding_end;
+  int64_t  end;
+  uint64_t winner;        // 0 if the auction has not been settled or ended with no winner
+  asset    bidamount;
+};
+
+// the latest auction's number and the auctions table scope that holds it: a season number, or the contract
+struct auction_head_row {
+  uint32_t number;
+  uint64_t scope;
+};
+
+// a bid in an auction's bid history ring
+struct bid_slot {
+  uint64_t bidder;        // 0 for a slot that has not been written
+  uint64_t amount;        // in the currency's smallest unit
+  uint32_t offset;        // seconds since the start of the auction
+};
+
+// the most recent bids of an auction. head is the slot the next bid overwrites, so the ring starts there
+struct bid_history_row {
+  uint32_t number;
+  uint8_t  head;
+  std::vector<bid_slot> slots;
+};
+
+struct nft_row {
+  uint32_t number;
+  uint64_t nftid;
+  std::vector<uint64_t> bundle;
+};
+
+struct parameter_row {
+  uint64_t    paramname;
+  std::string value;
+};
+
+struct user_row {
+  int64_t     time;
+  uint64_t    account;
+  std::string principal;
+};
+
+struct admin_row {
+  uint64_t account;
+};
+
+struct system_row {
+  int64_t  init;
+  uint32_t usercount;
+  asset    cls;
+};
+
+struct subaccount_row {
+  uint64_t id;
+  asset    amount;
+};
+
+struct custodian_row {
+  uint64_t account;
+  asset    held;
+  uint64_t bid_subaccount;
+  uint64_t bid_nftid;
+  asset    bid_amount;
+};
+
+
+// NAMES
+
+inline uint64_t name_value(const std::string &text) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < 13 && i < text.size(); i++) {
+    char c = text[i];
+    uint64_t v = (c >= 'a' && c <= 'z') ? uint64_t(c - 'a') + 6 : (c >= '1' && c <= '5') ? uint64_t(c - '1') + 1 : 0;
+    value |= (i < 12) ? (v & 0x1f) << (64 - 5 * (i + 1)) : (v & 0x0f);
+  }
+  return value;
+}
+
+inline std::string name_string(uint64_t value) {
+  static const char *charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+  std::string text(13, '.');
+  uint64_t v = value;
+  for (int i = 0; i < 13; i++) {
+    uint64_t c = (i == 0) ? (v & 0x0f) : (v & 0x1f);
+    text[12 - i] = charmap[c];
+    v >>= (i == 0) ? 4 : 5;
+  }
+  size_t last = text.find_last_not_of('.');
+  return (last == std::string::npos) ? "" : text.substr(0, last + 1);
+}
+
+
+// BINARY DECODING
+
+class reader {
+  const std::vector<uint8_t> &data;
+  size_t pos = 0;
+
+public:
+  explicit reader(const std::vector<uint8_t> &bytes) : data(bytes) {}
+
+  bool at_end() const { return pos >= data.size(); }
+
+  uint64_t read_uint(size_t size) {
+    if (pos + size > data.size()) throw std::runtime_error("row is shorter than its type");
+    uint64_t v = 0;
+    for (size_t i = 0; i < size; i++) v |= uint64_t(data[pos + i]) << (8 * i);
+    pos += size;
+    return v;
+  }
+
+  uint32_t read_varuint32() {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      uint8_t b = uint8_t(read_uint(1));
+      v |= uint32_t(b & 0x7f) << shift;
+      if (!(b & 0x80)) break;
+    }
+    return v;
+  }
+
+  asset read_asset() {
+    asset a;
+    a.amount = int64_t(read_uint(8));
+    a.symbol = read_uint(8);
+    return a;
+  }
+
+  std::string read_string() {
+    uint32_t size = read_varuint32();
+    if (pos + size > data.size()) throw std::runtime_error("row is shorter than its type");
+    std::string s(data.begin() + pos, data.begin() + pos + size);
+    pos += size;
+    return s;
+  }
+
+  std::vector<uint64_t> read_uint64_vector() {
+    std::vector<uint64_t> v(read_varuint32());
+    for (auto &x : v) x = read_uint(8);
+    return v;
+  }
+};
+
+inline void decode(reader &r, credit_row &row) { row.amount = r.read_asset(); }
+
+inline void decode(reader &r, bid_row &row) {
+  row.bidtime = int64_t(r.read_uint(8));
+  row.bidder = r.read_uint(8);
+  row.bidamount = r.read_asset();
+  row.nftid = r.read_uint(8);
+}
+
+inline void decode(reader &r, auction_row &row) {
+  row.number = uint32_t(r.read_uint(4));
+  row.nftid = r.read_uint(8);
+  row.start = int64_t(r.read_uint(8));
+  row.bidding_end = int64_t(r.read_uint(8));
+  row.end = int64_t(r.read_uint(8));
+  row.winner = r.read_uint(8);
+  row.bidamount = r.read_asset();
+}
+
+inline void decode(reader &r, auction_head_row &row) {
+  row.number = uint32_t(r.read_uint(4));
+  row.scope = r.read_uint(8);
+}
+
+inline void decode(reader &r, bid_history_row &row) {
+  row.number = uint32_t(r.read_uint(4));
+  row.head = uint8_t(r.read_uint(1));
+  row.slots.resize(r.read_varuint32());
+  for (auto &slot : row.slots) {
+    slot.bidder = r.read_uint(8);
+    slot.amount = r.read_uint(8);
+    slot.offset = uint32_t(r.read_uint(4));
+  }
+}
+
+inline void decode(reader &r, nft_row &row) {
+  row.number = uint32_t(r.read_uint(4));
+  row.nftid = r.read_uint(8);
+  // the bundle is a binary extension, absent from rows written before bundles existed
+  row.bundle = r.at_end() ? std::vector<uint64_t>() : r.read_uint64_vector();
+}
+
+inline void decode(reader &r, parameter_row &row) {
+  row.paramname = r.read_uint(8);
+  row.value = r.read_string();
+}
+
+inline void decode(reader &r, user_row &row) {
+  row.time = int64_t(r.read_uint(8));
+  row.account = r.read_uint(8);
+  row.principal = r.read_string();
+}
+
+inline void decode(reader &r, admin_row &row) { row.account = r.read_uint(8); }
+
+inline void decode(reader &r, system_row &row) {
+  row.init = int64_t(r.read_uint(8));
+  row.usercount = uint32_t(r.read_uint(4));
+  row.cls = r.read_asset();
+}
+
+inline void decode(reader &r, subaccount_row &row) {
+  row.id = r.read_uint(8);
+  row.amount = r.read_asset();
+}
+
+inline void decode(reader &r, custodian_row &row) {
+  row.account = r.read_uint(8);
+  row.held = r.read_asset();
+  row.bid_subaccount = r.read_uint(8);
+  row.bid_nftid = r.read_uint(8);
+  row.bid_amount = r.read_asset();
+}
+
+inline std::vector<uint8_t> from_hex(const std::string &hex) {
+  auto nibble = [](char c) -> uint8_t {
+    if (c >= '0' && c <= '9') return uint8_t(c - '0');
+    if (c >= 'a' && c <= 'f') return uint8_t(c - 'a' + 10);
+    if (c >= 'A' && c <= 'F') return uint8_t(c - 'A' + 10);
+    throw std::runtime_error("invalid hex row");
+  };
+
+  std::vector<uint8_t> bytes(hex.size() / 2);
+  for (size_t i = 0; i < bytes.size(); i++) bytes[i] = uint8_t(nibble(hex[2 * i]) << 4 | nibble(hex[2 * i + 1]));
+  return bytes;
+}
+
+
+// GET_TABLE_ROWS
+
+struct table_query {
+  std::string scope;
+  std::string table;
+  int         index_position = 1;   // 1 is the primary key, 2 the first secondary index
+  std::string lower_bound;
+  std::string upper_bound;
+  uint32_t    limit = 100;
+  bool        reverse = false;
+};
+
+// the rows of a get_table_rows response, still packed
+struct table_page {
+  std::vector<std::vector<uint8_t>> rows;
+  bool        more = false;
+  std::string next_key;
+};
+
+// reads the packed rows of a get_table_rows response made with "json": false. Each row is a hex string, or an
+// object with the hex string in "data" when the payer is shown
+inline table_page parse_page(const std::string &body) {
+  table_page page;
+
+  auto read_string_at = [&](size_t quote) {
+    size_t close = body.find('"', quote + 1);
+    if (close == std::string::npos) throw std::runtime_error("malformed response");
+    return body.substr(quote + 1, close - quote - 1);
+  };
+
+  size_t rows = body.find("\"rows\"");
+  if (rows == std::string::npos) throw std::runtime_error("response has no rows: " + body.substr(0, 200));
+  size_t pos = body.find('[', rows);
+  size_t end = body.find(']', pos);
+
+  while (pos != std::string::npos && pos < end) {
+    size_t next = body.find_first_of("\"{", pos + 1);
+    if (next == std::string::npos || next > end) break;
+
+    if (body[next] == '{') {
+      size_t data = body.find("\"data\"", next);
+      size_t quote = body.find('"', body.find(':', data));
+      page.rows.push_back(from_hex(read_string_at(quote)));
+      pos = body.find('}', quote);
+    } else {
+      std::string hex = read_string_at(next);
+      page.rows.push_back(from_hex(hex));
+      pos = next + hex.size() + 1;
+    }
+  }
+
+  size_t more = body.find("\"more\"", end);
+  if (more != std::string::npos) {
+    size_t value = body.find_first_not_of(" :", more + 6);
+    page.more = body.compare(value, 4, "true") == 0;
+  }
+
+  size_t next_key = body.find("\"next_key\"", end);
+  if (next_key != std::string::npos) {
+    size_t quote = body.find('"', body.find(':', next_key));
+    if (quote != std::string::npos) page.next_key = read_string_at(quote);
+  }
+
+  return page;
+}
+
+template<typename Row>
+std::vector<Row> decode_rows(const table_page &page) {
+  std::vector<Row> rows;
+  for (const auto &packed : page.rows) {
+    reader r(packed);
+    Row row;
+    decode(r, row);
+    rows.push_back(row);
+  }
+  return rows;
+}
+
+
+// HTTP
+
+// a keep-alive HTTP/1.1 connection that writes a batch of requests before reading the responses
+class connection {
+  std::string host;
+  std::string port;
+  int fd = -1;
+  std::string buffer;
+
+public:
+  connection(const std::string &h, const std::string &p) : host(h), port(p) {}
+  ~connection() { close(); }
+
+  connection(const connection &) = delete;
+  connection &operator=(const connection &) = delete;
+
+  void close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    buffer.clear();
+  }
+
+  // posts the bodies to the path and returns the response bodies in the same order
+  std::vector<std::string> post_all(const std::string &path, const std::vector<std::string> &bodies) {
+    if (bodies.empty()) return {};
+
+    try {
+      return exchange(path, bodies);
+    } catch (const std::exception &) {
+      // the node may have closed an idle connection: try once more on a new one
+      close();
+      return exchange(path, bodies);
+    }
+  }
+
+private:
+  void open() {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *found = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0) throw std::runtime_error("cannot resolve " + host);
+
+    for (addrinfo *a = found; a != nullptr; a = a->ai_next) {
+      fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (fd < 0) continue;
+      if (::connect(fd, a->ai_addr, a->ai_addrlen) == 0) break;
+      ::close(fd);
+      fd = -1;
+    }
+    freeaddrinfo(found);
+
+    if (fd < 0) throw std::runtime_error("cannot connect to " + host + ":" + port);
+  }
+
+  std::vector<std::string> exchange(const std::string &path, const std::vector<std::string> &bodies) {
+    if (fd < 0) open();
+
+    std::string requests;
+    for (const auto &body : bodies) {
+      requests += "POST " + path + " HTTP/1.1\r\nHost: " + host + "\r\nContent-Type: application/json\r\n"
+        "Connection: keep-alive\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+
+    for (size_t sent = 0; sent < requests.size();) {
+      ssize_t n = ::send(fd, requests.data() + sent, requests.size() - sent, 0);
+      if (n <= 0) throw std::runtime_error("send failed");
+      sent += size_t(n);
+    }
+
+    std::vector<std::string> responses;
+    for (size_t i = 0; i < bodies.size(); i++) responses.push_back(read_response());
+    return responses;
+  }
+
+  void fill() {
+    char chunk[16384];
+    ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) throw std::runtime_error("connection closed");
+    buffer.append(chunk, size_t(n));
+  }
+
+  std::string take(size_t size) {
+    while (buffer.size() < size) fill();
+    std::string data = buffer.substr(0, size);
+    buffer.erase(0, size);
+    return data;
+  }
+
+  std::string take_line() {
+    size_t eol;
+    while ((eol = buffer.find("\r\n")) == std::string::npos) fill();
+    std::string line = buffer.substr(0, eol);
+    buffer.erase(0, eol + 2);
+    return line;
+  }
+
+  std::string read_response() {
+    std::string status = take_line();
+    if (status.compare(0, 5, "HTTP/") != 0) throw std::runtime_error("malformed response");
+    int code = std::atoi(status.c_str() + status.find(' ') + 1);
+
+    size_t content_length = 0;
+    bool chunked = false;
+    for (std::string line = take_line(); !line.empty(); line = take_line()) {
+      std::string key = line.substr(0, line.find(':'));
+      for (auto &c : key) c = char(tolower(c));
+      std::string value = line.substr(line.find(':') + 1);
+      value.erase(0, value.find_first_not_of(' '));
+
+      if (key == "content-length") content_length = size_t(std::stoul(value));
+      if (key == "transfer-encoding" && value.find("chunked") != std::string::npos) chunked = true;
+    }
+
+    std::string body;
+    if (chunked) {
+      for (size_t size = std::stoul(take_line(), nullptr, 16); size > 0; size = std::stoul(take_line(), nullptr, 16)) {
+        body += take(size);
+        take_line();
+      }
+      take_line();
+    } else {
+      body = take(content_length);
+    }
+
+    if (code != 200) throw std::runtime_error("node returned " + std::to_string(code) + ": " + body.substr(0, 200));
+    return body;
+  }
+};
+
+
+// CLIENT
+
+class client {
+  // the number of auctions table scopes read in one round trip
+  static constexpr size_t SCOPE_BATCH = 8;
+
+  connection conn;
+  std::string contract;
+
+  // settled auctions by number. They are never modified again, so they are read from the node only once
+  std::map<uint32_t, auction_row> settled_auctions;
+
+public:
+  client(const std::string &host, const std::string &port, const std::string &contract_account)
+    : conn(host, port), contract(contract_account) {}
+
+  // runs a batch of queries over the connection and returns a page for each, in the same order
+  std::vector<table_page> query(const std::vector<table_query> &queries) {
+    std::vector<std::string> bodies;
+    for (const auto &q : queries) bodies.push_back(request_body(q));
+
+    std::vector<table_page> pages;
+    for (const auto &response : conn.post_all("/v1/chain/get_table_rows", bodies)) pages.push_back(parse_page(response));
+    return pages;
+  }
+
+  // the credit of each user, zero for users without a credit record. One batch for all the users
+  std::map<std::string, asset> credits(const std::vector<std::string> &users) {
+    std::vector<table_query> queries;
+    for (const auto &user : users) {
+      table_query q;
+      q.scope = user;
+      q.table = "credits";
+      q.limit = 1;
+      queries.push_back(q);
+    }
+
+    std::map<std::string, asset> result;
+    std::vector<table_page> pages = query(queries);
+    for (size_t i = 0; i < users.size(); i++) {
+      std::vector<credit_row> rows = decode_rows<credit_row>(pages[i]);
+      result[users[i]] = rows.empty() ? asset() : rows.front().amount;
+    }
+    return result;
+  }
+
+  // the bids of the current auction, highest first
+  std::vector<bid_row> bids() {
+    table_query q;
+    q.scope = contract;
+    q.table = "bids";
+    q.index_position = 2;   // byamount
+    q.reverse = true;
+    return decode_rows<bid_row>(query({q}).front());
+  }
+
+  // the nft queue in auction order
+  std::vector<nft_row> nfts(uint32_t limit = 100) {
+    table_query q;
+    q.scope = contract;
+    q.table = "nfts";
+    q.limit = limit;
+    return decode_rows<nft_row>(query({q}).front());
+  }
+
+  std::vector<parameter_row> parameters() {
+    table_query q;
+    q.scope = contract;
+    q.table = "parameters";
+    return decode_rows<parameter_row>(query({q}).front());
+  }
+
+  // the latest auctions, newest first. Settled auctions come from the cache, and the node is asked only for the
+  // auctions between the cached ones
+  std::vector<auction_row> latest_auctions(uint32_t count) {
+    auction_head_row head;
+    std::vector<std::string> scopes = auction_scopes(head);
+
+    // walk down from the head: take the auctions the cache holds, and read the runs it does not hold from the
+    // scopes, newest first and SCOPE_BATCH to a round trip
+    std::vector<auction_row> rows;
+    uint32_t below = head.number + 1;   // the next auction wanted is the newest numbered below this
+    size_t first_scope = 0;             // no auction below `below` is in a newer scope than this
+    while (rows.size() < count && below > 1 && first_scope < scopes.size()) {
+      auto cached = settled_auctions.find(below - 1);
+      if (cached != settled_auctions.end()) {
+        rows.push_back(cached->second);
+        below--;
+        continue;
+      }
+
+      // the run ends at the next cached auction
+      auto next_cached = settled_auctions.lower_bound(below - 1);
+      uint32_t run_end = (next_cached == settled_auctions.begin()) ? 0 : std::prev(next_cached)->first;
+
+      std::vector<table_query> queries;
+      for (size_t i = first_scope; i < scopes.size() && i < first_scope + SCOPE_BATCH; i++) {
+        table_query q;
+        q.scope = scopes[i];
+        q.table = "auctions";
+        q.limit = count - uint32_t(rows.size());
+        q.reverse = true;
+        q.lower_bound = std::to_string(run_end + 1);
+        q.upper_bound = std::to_string(below - 1);
+        queries.push_back(q);
+      }
+
+      std::vector<table_page> pages = query(queries);
+      size_t last_scope = first_scope;
+      for (size_t k = 0; k < pages.size(); k++) {
+        for (const auto &a : decode_rows<auction_row>(pages[k])) {
+          if (rows.size() >= count) break;
+          rows.push_back(a);
+          below = a.number;
+          last_scope = first_scope + k;
+
+          // an auction with a winner has been settled; so has every auction older than the newest one
+          if (a.winner != 0 || a.number != head.number) settled_auctions[a.number] = a;
+        }
+      }
+
+      // once the run has been read down to the cached auction, the scope of the last auction read may hold
+      // auctions below the cached ones. Otherwise the scopes read hold nothing more of the run. A page cut short
+      // by its limit always fills rows up to count
+      first_scope = (below == run_end + 1) ? last_scope : first_scope + pages.size();
+    }
+    return rows;
+  }
+
+  // the scopes that hold rows of the table, in scope order, from /v1/chain/get_table_by_scope. Scopes come back as
+  // names; a numeric scope such as a season is the name with the same value
+  std::vector<std::string> table_scopes(const std::string &table) {
+    std::vector<std::string> scopes;
+    std::string lower;
+    for (;;) {
+      std::string body = "{\"code\":\"" + contract + "\",\"table\":\"" + table + "\",\"limit\":1000";
+      if (!lower.empty()) body += ",\"lower_bound\":\"" + lower + "\"";
+      std::string response = conn.post_all("/v1/chain/get_table_by_scope", {body + "}"}).front();
+
+      size_t rows_end = response.find(']');
+      for (size_t at = response.find("\"scope\""); at != std::string::npos && at < rows_end; at = response.find("\"scope\"", at + 1)) {
+        size_t quote = response.find('"', response.find(':', at));
+        scopes.push_back(response.substr(quote + 1, response.find('"', quote + 1) - quote - 1));
+      }
+
+      size_t more = response.find("\"more\"", rows_end);
+      if (more == std::string::npos) break;
+      size_t quote = response.find_first_not_of(" :", more + 6);
+      if (response[quote] != '"') break;
+      lower = response.substr(quote + 1, response.find('"', quote + 1) - quote - 1);
+      if (lower.empty()) break;
+    }
+    return scopes;
+  }
+
+  // every row of the table in each of the scopes, with its scope. The scopes are read SCOPE_BATCH to a round
+  // trip, and the further pages of a batch's scopes are requested together
+  template<typename Row>
+  std::vector<std::pair<std::string, Row>> scoped_rows(const std::string &table, const std::vector<std::string> &scopes) {
+    std::vector<std::pair<std::string, Row>> found;
+    for (size_t first = 0; first < scopes.size(); first += SCOPE_BATCH) {
+      size_t batch = std::min(SCOPE_BATCH, scopes.size() - first);
+      std::vector<std::vector<Row>> scope_rows(batch);
+      std::vector<std::string> lower(batch);
+      std::vector<size_t> pending(batch);
+      for (size_t i = 0; i < batch; i++) pending[i] = i;
+
+      while (!pending.empty()) {
+        std::vector<table_query> queries;
+        for (size_t i : pending) {
+          table_query q;
+          q.scope = scopes[first + i];
+          q.table = table;
+          q.lower_bound = lower[i];
+          queries.push_back(q);
+        }
+
+        std::vector<table_page> pages = query(queries);
+        std::vector<size_t> more;
+        for (size_t k = 0; k < pending.size(); k++) {
+          size_t i = pending[k];
+          for (const auto &row : decode_rows<Row>(pages[k])) scope_rows[i].push_back(row);
+          if (pages[k].more && !pages[k].next_key.empty()) {
+            lower[i] = pages[k].next_key;
+            more.push_back(i);
+          }
+        }
+        pending = more;
+      }
+
+      for (size_t i = 0; i < batch; i++) {
+        for (const auto &row : scope_rows[i]) found.emplace_back(scopes[first + i], row);
+      }
+    }
+    return found;
+  }
+
+  // the bid histories of the auctions numbered first to last, in number order. The contract keeps the history of
+  // every auction until the auctions table is cleared or the auction's season is dropped
+  std::vector<bid_history_row> bid_histories(uint32_t first, uint32_t last) {
+    std::vector<bid_history_row> histories;
+    std::string lower = std::to_string(first);
+    for (;;) {
+      table_query q;
+      q.scope = contract;
+      q.table = "bidhistory";
+      q.lower_bound = lower;
+      q.upper_bound = std::to_string(last);
+      table_page page = query({q}).front();
+
+      for (const auto &h : decode_rows<bid_history_row>(page)) histories.push_back(h);
+      if (!page.more || page.next_key.empty()) break;
+      lower = page.next_key;
+    }
+    return histories;
+  }
+
+  // every auction numbered after number, oldest first. The scopes are read SCOPE_BATCH to a round trip, and the
+  // further pages of all the scopes in a batch are requested together
+  std::vector<auction_row> auctions_after(uint32_t number) {
+    auction_head_row head;
+    std::vector<std::string> scopes = auction_scopes(head);
+
+    std::vector<auction_row> found;
+    for (size_t first = 0; first < scopes.size(); first += SCOPE_BATCH) {
+      if (head.number <= number || (!found.empty() && found.front().number == number + 1)) break;
+
+      size_t batch = std::min(SCOPE_BATCH, scopes.size() - first);
+      std::vector<std::vector<auction_row>> scope_rows(batch);
+      std::vector<std::string> lower(batch, std::to_string(number + 1));
+      std::vector<size_t> pending(batch);
+      for (size_t i = 0; i < batch; i++) pending[i] = i;
+
+      while (!pending.empty()) {
+        std::vector<table_query> queries;
+        for (size_t i : pending) {
+          table_query q;
+          q.scope = scopes[first + i];
+          q.table = "auctions";
+          q.lower_bound = lower[i];
+          queries.push_back(q);
+        }
+
+        std::vector<table_page> pages = query(queries);
+        std::vector<size_t> more;
+        for (size_t k = 0; k < pending.size(); k++) {
+          size_t i = pending[k];
+          for (const auto &a : decode_rows<auction_row>(pages[k])) scope_rows[i].push_back(a);
+          if (pages[k].more && !pages[k].next_key.empty()) {
+            lower[i] = pages[k].next_key;
+            more.push_back(i);
+          }
+        }
+        pending = more;
+      }
+
+      // an older scope holds older auctions
+      for (size_t i = 0; i < batch; i++) {
+        found.insert(found.begin(), scope_rows[i].begin(), scope_rows[i].end());
+      }
+    }
+    return found;
+  }
+
+private:
+  // the auctions table scopes, newest first: the season scopes from the latest auction's down to season 1, then
+  // the contract's, which holds the auctions written before seasons. head is set to the auction head, or to
+  // the latest auction in the contract's scope if there is no head
+  std::vector<std::string> auction_scopes(auction_head_row &head) {
+    table_query q;
+    q.scope = contract;
+    q.table = "auctionhead";
+    q.limit = 1;
+
+    table_query legacy;
+    legacy.scope = contract;
+    legacy.table = "auctions";
+    legacy.limit = 1;
+    legacy.reverse = true;
+
+    std::vector<table_page> pages = query({q, legacy});
+    std::vector<auction_head_row> heads = decode_rows<auction_head_row>(pages[0]);
+    std::vector<auction_row> latest = decode_rows<auction_row>(pages[1]);
+
+    std::vector<std::string> scopes;
+    head.scope = name_value(contract);
+    head.number = latest.empty() ? 0 : latest.front().number;
+    if (!heads.empty()) {
+      head = heads.front();
+      if (head.scope != name_value(contract)) {
+        for (uint64_t season = head.scope; season >= 1; season--) scopes.push_back(std::to_string(season));
+      }
+    }
+    scopes.push_back(contract);
+    return scopes;
+  }
+
+  std::string request_body(const table_query &q) const {
+    std::string body = "{\"code\":\"" + contract + "\",\"scope\":\"" + q.scope + "\",\"table\":\"" + q.table +
+      "\",\"index_position\":\"" + std::to_string(q.index_position) + "\",\"key_type\":\"i64\",\"json\":false" +
+      ",\"limit\":" + std::to_string(q.limit) + ",\"reverse\":" + (q.reverse ? "true" : "false");
+    if (!q.lower_bound.empty()) body += ",\"lower_bound\":\"" + q.lower_bound + "\"";
+    if (!q.upper_bound.empty()) body += ",\"upper_bound\":\"" + q.upper_bound + "\"";
+    return body + "}";
+  }
+};
+
+} // namespace cronacle_client
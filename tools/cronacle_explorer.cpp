@@ -0,0 +1,699 @@
+// cronacle_explorer searches for action sequences that make a single contract action as expensive as possible,
+// to check before a release that no action can be pushed past the chain's CPU limit as the tables grow.
+//
+// Build:  g++ -std=c++17 -O2 -Wno-attributes -Itools/native -o cronacle_explorer tools/cronacle_explorer.cpp
+//         add -fsanitize-coverage=trace-pc to rank by basic blocks executed
+// Usage:  cronacle_explorer [explore] [options]
+//         cronacle_explorer replay FILE [--rank R]
+//         cronacle_explorer costs
+//
+//   --rank R         what an action costs: dbops, the operations counted by the CRONACLE_DBTRACE build, summed over
+//                    the tables; intrinsics, the database intrinsics the CDT calls for them; or blocks, the basic
+//                    blocks executed, contract and host together, as a stand-in for instructions (default dbops)
+//   --rounds N       random starting sequences                                    (default 20)
+//   --mutations N    mutations tried on each starting sequence                    (default 60)
+//   --steps N        steps in a starting sequence                                 (default 10)
+//   --scale N        the largest repeat count of a step                          (default 200)
+//   --limit N        the most an action may cost; exceeding it gives exit status 1 (default none)
+//   --top N          reproducers printed                                          (default 5)
+//   --seed N         random seed                                                  (default 1)
+//
+// The contract is compiled in, over the native host in tools/native, with CRONACLE_DBTRACE defined, so the
+// actions run the contract's own code and tables. A sequence is a list of steps; a step runs one kind of action
+// a number of times, with its account and nft arguments advancing on each repeat, after moving the clock on, so
+// that a few steps build large state shapes: many users, bids, pre-bids, queued nfts, sub-accounts or seasons.
+// Every action is run, as on the chain, in its own transaction, and a failed check undoes it. The cost of a
+// sequence is the cost of its most expensive action, failed or not.
+//
+// explore starts from random sequences and mutates each one, keeping a mutation if it costs at least as much:
+// steps are inserted, removed, duplicated or changed, and repeat counts doubled or halved. The most expensive
+// sequence found for each kind of action is then shrunk: it is cut after the expensive action, and steps are
+// removed and repeat counts and clock moves lowered while the action still costs as much. The shrunk sequences
+// are printed as reproducers, which replay runs again, printing the cost of every action.
+//
+// costs prints the database operations of the action paths that tools/cronacle_simulator models, in the form
+// of the simulator's DB_OPS_* constants, to be pasted in when the contract changes.
+//
+// A reproducer has one step per line: the seconds the clock moves on, the kind of action, two arguments and the
+// repeat count. Lines starting with # are comments.
+
+#define CRONACLE_DBTRACE
+#include "../cronacle.cpp"
+#include "../cronacle_rules.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+using namespace eosio;
+
+// basic blocks executed, counted when built with -fsanitize-coverage=trace-pc
+static uint64_t executed_blocks = 0;
+
+extern "C" __attribute__((no_sanitize_coverage)) void __sanitizer_cov_trace_pc() {
+  executed_blocks++;
+}
+
+const name SELF = "cronacle"_n;
+const name TOKEN_CONTRACT = "freeostokens"_n;
+const name ADMIN = "admin"_n;
+const symbol CREDIT_SYMBOL = symbol("FREEOS", 4);
+const int64_t UNIT = 10000;
+
+// the clock when a sequence starts, and the auction parameters it starts with
+const int64_t START_SECS = 1000000;
+const uint32_t AUCTION_PERIOD_SECS = 100;
+const uint32_t BID_PERIOD_SECS = 60;
+
+// the maintain actions that the fuzzer calls
+const std::vector<std::string> MAINTAIN_ACTIONS = {"unregister", "touch", "track credit", "index bundles", "clear users",
+  "clear auctions", "clear bids", "highest bid", "reset", "clear credit"};
+
+enum class rank_by { dbops, intrinsics, blocks };
+
+
+struct step {
+  uint32_t advance;   // seconds the clock moves on before the step
+  std::string kind;
+  uint32_t a;
+  uint32_t b;
+  uint32_t repeat;
+};
+
+typedef std::vector<step> sequence;
+
+// the most expensive action of a run
+struct worst_action {
+  uint64_t cost = 0;
+  size_t step = 0;       // its step in the sequence
+  std::string kind;
+  std::string failure;   // the check that failed, if it failed
+};
+
+
+// an account for the fuzzer's users: user followed by the index in letters
+name account(uint32_t index) {
+  std::string text = "user";
+  do {
+    text += char('a' + index % 26);
+    index /= 26;
+  } while (index > 0);
+  return name(text);
+}
+
+
+// runs sequences on the native host and measures their actions
+class runner {
+  rank_by rank;
+
+  worst_action *worst = nullptr;
+  size_t current_step = 0;
+  std::string current_kind;
+  uint32_t next_nftid = 1000;
+
+public:
+  // the cost of every action, for replay
+  std::function<void(const std::string &kind, uint64_t cost, const std::string &failure)> trace;
+
+  explicit runner(rank_by r) : rank(r) {}
+
+  worst_action run(const sequence &steps) {
+    worst_action result;
+    worst = &result;
+    current_kind.clear();
+    setup();
+
+    for (current_step = 0; current_step < steps.size(); current_step++) {
+      const step &s = steps[current_step];
+      current_kind = s.kind;
+      native::host().now_us += int64_t(s.advance) * 1000000;
+      for (uint32_t i = 0; i < std::max(1u, s.repeat); i++) run_step(s, i);
+    }
+
+    worst = nullptr;
+    return result;
+  }
+
+private:
+  // runs one action in its own transaction and records its cost
+  template<typename F>
+  bool call(std::vector<name> auths, name code, F &&body) {
+    native::host_state &host = native::host();
+    host.begin_action(std::move(auths));
+    // the runner's own reads of the tables are traced too
+    dbtrace_profile().clear();
+    uint64_t blocks_before = executed_blocks;
+    uint64_t dbops = 0;
+    std::string failure;
+
+    try {
+      cronacle contract(SELF, code, datastream<const char *>(nullptr, 0));
+      try {
+        body(contract);
+      } catch (const check_failure &e) {
+        failure = e.what();
+      }
+      for (const auto &table : dbtrace_profile()) dbops += dbtrace_ops(table.second);
+    } catch (const check_failure &e) {
+      if (failure.empty()) failure = e.what();
+    }
+
+    uint64_t cost = (rank == rank_by::dbops) ? dbops : (rank == rank_by::intrinsics) ? host.intrinsics.total()
+      : executed_blocks - blocks_before;
+
+    if (failure.empty()) host.commit();
+    else host.revert();
+
+    // the setup's actions are not part of the sequence
+    if (current_kind.empty()) return failure.empty();
+    if (worst != nullptr && (cost > worst->cost || worst->kind.empty())) *worst = {cost, current_step, current_kind, failure};
+    if (trace) trace(current_kind, cost, failure);
+    return failure.empty();
+  }
+
+  static uint64_t dbtrace_ops(const dbtrace_counts &c) {
+    return uint64_t(c.find) + c.begin + c.next + c.emplace + c.modify + c.erase + c.idx + c.idx_find + c.idx_begin +
+      c.idx_next + c.idx_modify + c.idx_erase;
+  }
+
+  void setup() {
+    native::host().reset();
+    native::host().now_us = START_SECS * 1000000;
+    next_nftid = 1000;
+
+    call({SELF}, SELF, [](cronacle &c) { c.paramupsert("currency"_n, "4 FREEOS freeostokens"); });
+    call({SELF}, SELF, [](cronacle &c) { c.paramupsert("auctperiod"_n, std::to_string(AUCTION_PERIOD_SECS)); });
+    call({SELF}, SELF, [](cronacle &c) { c.paramupsert("bidperiod"_n, std::to_string(BID_PERIOD_SECS)); });
+    call({SELF}, SELF, [](cronacle &c) { c.paramupsert("minimumbid"_n, "1"); });
+    call({SELF}, SELF, [](cronacle &c) { c.paramupsert("bidstep"_n, "1"); });
+    call({SELF}, SELF, [](cronacle &c) { c.updateadmin(ADMIN, false); });
+    call({SELF}, SELF, [](cronacle &c) { c.init(time_point(seconds(START_SECS))); });
+    for (int i = 0; i < 3; i++) add_nft();
+  }
+
+  void add_nft() {
+    uint64_t nftid = next_nftid++;
+    call({ADMIN}, SELF, [&](cronacle &c) { c.addnft(ADMIN, 0, nftid); });
+  }
+
+  // the queued nfts, in queue order; read outside any action, so not counted
+  std::vector<nft> queue() const {
+    std::vector<nft> entries;
+    nfts_index nfts_table(SELF, SELF.value);
+    for (const auto &entry : nfts_table) entries.push_back(entry);
+    return entries;
+  }
+
+  // the lowest bid that beats the highest bid on an nft: its highest open bid once its auction has opened, or
+  // before that its highest pre-bid, which becomes an opening bid
+  asset minimum_bid(uint64_t nft_id) const {
+    int64_t highest = 0;
+    bids_index bids_table(SELF, SELF.value);
+    if (bids_table.begin() != bids_table.end() && bids_table.begin()->nftid == nft_id) {
+      highest = bids_table.get_index<"byamount"_n>().rbegin()->bidamount.amount;
+    } else {
+      prebids_index prebids_table(SELF, nft_id);
+      auto amount_idx = prebids_table.get_index<"byamount"_n>();
+      if (amount_idx.begin() != amount_idx.end()) highest = amount_idx.rbegin()->bidamount.amount;
+    }
+    return asset(cronacle_rules::minimum_next_bid(highest, UNIT, UNIT), CREDIT_SYMBOL);
+  }
+
+  name leader() const {
+    bids_index bids_table(SELF, SELF.value);
+    auto amount_idx = bids_table.get_index<"byamount"_n>();
+    return (amount_idx.begin() == amount_idx.end()) ? name() : amount_idx.rbegin()->bidder;
+  }
+
+  uint64_t target_nft(uint32_t b) const {
+    std::vector<nft> entries = queue();
+    size_t position = b % 2;
+    return position < entries.size() ? entries[position].nftid : 0;
+  }
+
+  // a deposit made by another kind of step is counted as a deposit
+  void deposit(name user, int64_t units, const std::string &memo) {
+    std::string step_kind = current_kind;
+    if (!step_kind.empty() && step_kind != "subdeposit") current_kind = "deposit";
+    call({user}, TOKEN_CONTRACT, [&](cronacle &c) { c.credit(user, SELF, asset(units * UNIT, CREDIT_SYMBOL), memo); });
+    current_kind = step_kind;
+  }
+
+  void run_step(const step &s, uint32_t i) {
+    name user = account(s.a + i);
+    const std::string &k = s.kind;
+
+    if (k == "deposit") {
+      deposit(user, 10 * (int64_t(s.b) + 1), "");
+    } else if (k == "subdeposit") {
+      deposit(account(s.a), 10 * (int64_t(s.b) + 1), "sub:" + std::to_string(s.b + i + 1));
+    } else if (k == "bid") {
+      uint64_t nft_id = target_nft(s.b);
+      asset amount = minimum_bid(nft_id);
+      deposit(user, amount.amount / UNIT, "");
+      call({user}, SELF, [&](cronacle &c) { c.bid(user, nft_id, amount, binary_extension<uint64_t>()); });
+    } else if (k == "subbid") {
+      name custodian = account(s.a);
+      uint64_t nft_id = target_nft(0);
+      asset amount = minimum_bid(nft_id);
+      deposit(custodian, amount.amount / UNIT, "sub:" + std::to_string(s.b + i + 1));
+      call({custodian}, SELF, [&](cronacle &c) { c.subbid(custodian, s.b + i + 1, nft_id, amount); });
+    } else if (k == "prebid") {
+      std::vector<nft> entries = queue();
+      if (entries.size() < 2) return;
+      uint64_t nft_id = entries[1 + s.b % (entries.size() - 1)].nftid;
+      asset amount = asset((1 + i % 50) * UNIT, CREDIT_SYMBOL);
+      deposit(user, amount.amount / UNIT, "");
+      call({user}, SELF, [&](cronacle &c) { c.prebid(user, nft_id, amount); });
+    } else if (k == "addnft") {
+      add_nft();
+    } else if (k == "addbundle") {
+      std::vector<uint64_t> nftids;
+      for (uint32_t n = 0; n < 2 + s.b % (MAX_BUNDLE_SIZE - 1); n++) nftids.push_back(next_nftid++);
+      call({ADMIN}, SELF, [&](cronacle &c) { c.addbundle(ADMIN, 0, nftids); });
+    } else if (k == "removenft") {
+      std::vector<nft> entries = queue();
+      if (entries.empty()) return;
+      uint32_t number = entries[(s.b + i) % entries.size()].number;
+      call({ADMIN}, SELF, [&](cronacle &c) { c.removenft(ADMIN, number); });
+    } else if (k == "claim") {
+      name winner = leader();
+      name claimant = winner ? winner : user;
+      call({claimant}, SELF, [&](cronacle &c) { c.claim(claimant); });
+    } else if (k == "withdraw") {
+      call({user}, SELF, [&](cronacle &c) { c.withdraw(user); });
+    } else if (k == "subwithdraw") {
+      name custodian = account(s.a);
+      std::vector<uint64_t> ids;
+      for (uint32_t n = 0; n < std::min<uint32_t>(s.b + 1, MAX_SUBACCOUNT_BATCH); n++) ids.push_back(n + 1);
+      call({custodian}, SELF, [&](cronacle &c) { c.subwithdraw(custodian, ids); });
+    } else if (k == "payout") {
+      call({user}, SELF, [&](cronacle &c) { c.payout(4 * (s.b + 1)); });
+    } else if (k == "gc") {
+      call({ADMIN}, SELF, [&](cronacle &c) { c.gc(ADMIN, 4 * (s.b + 1), 0); });
+    } else if (k == "closeaccount") {
+      call({user}, SELF, [&](cronacle &c) { c.closeaccount(user); });
+    } else if (k == "maintain") {
+      const std::string &action = MAINTAIN_ACTIONS[s.b % MAINTAIN_ACTIONS.size()];
+      call({SELF}, SELF, [&](cronacle &c) { c.maintain(action, user, binary_extension<uint64_t>(), binary_extension<vector<name>>()); });
+    } else if (k == "dropseason") {
+      call({SELF}, SELF, [&](cronacle &c) { c.dropseason(1 + s.b % 8); });
+    } else if (k == "migrate") {
+      call({SELF}, SELF, [&](cronacle &c) { c.migrate(4 * (s.b + 1)); });
+    } else if (k == "balances") {
+      std::vector<name> accounts;
+      for (uint32_t n = 0; n <= s.b; n++) accounts.push_back(account(s.a + n));
+      call({user}, SELF, [&](cronacle &c) { c.balances(accounts); });
+    } else if (k == "allbalances") {
+      call({user}, SELF, [&](cronacle &c) { c.allbalances(name(), 4 * (s.b + 1)); });
+    } else if (k == "setprincipal") {
+      std::string principal = "p" + std::to_string((s.a + i) % (s.b + 1)) + "-cai";
+      call({user}, SELF, [&](cronacle &c) { c.setprincipal(user, principal); });
+    } else if (k == "getaccount") {
+      std::string principal = "p" + std::to_string(s.b) + "-cai";
+      call({user}, SELF, [&](cronacle &c) { c.getaccount(principal); });
+    } else if (k == "param") {
+      static const std::vector<std::pair<name, std::string>> settings = {{"batchwindow"_n, "10"},
+        {"payoutqueue"_n, "1"}, {"dropunsold"_n, "1"}, {"seasonlen"_n, "1000"}};
+      const auto &setting = settings[s.b % settings.size()];
+      if (s.a % 2 == 0) call({SELF}, SELF, [&](cronacle &c) { c.paramupsert(setting.first, setting.second); });
+      else call({SELF}, SELF, [&](cronacle &c) { c.paramerase(setting.first); });
+    }
+    // wait only moves the clock
+  }
+};
+
+const std::vector<std::string> STEP_KINDS = {"deposit", "subdeposit", "bid", "subbid", "prebid", "addnft", "addbundle",
+  "removenft", "claim", "withdraw", "subwithdraw", "payout", "gc", "closeaccount", "maintain", "dropseason", "migrate",
+  "balances", "allbalances", "setprincipal", "getaccount", "param", "wait"};
+
+
+struct options {
+  rank_by rank = rank_by::dbops;
+  int rounds = 20;
+  int mutations = 60;
+  int steps = 10;
+  uint32_t scale = 200;
+  uint64_t limit = 0;
+  int top = 5;
+  uint64_t seed = 1;
+};
+
+
+class explorer {
+  const options &opt;
+  runner run;
+  std::mt19937_64 rng;
+
+  // the most expensive sequence found for each kind of action
+  std::map<std::string, std::pair<worst_action, sequence>> worst_by_kind;
+
+public:
+  explicit explorer(const options &o) : opt(o), run(o.rank), rng(o.seed) {}
+
+  int explore() {
+    for (int round = 0; round < opt.rounds; round++) {
+      sequence current = random_sequence();
+      worst_action current_worst = evaluate(current);
+
+      for (int m = 0; m < opt.mutations; m++) {
+        sequence candidate = mutate(current);
+        worst_action candidate_worst = evaluate(candidate);
+        if (candidate_worst.cost >= current_worst.cost) {
+          current = candidate;
+          current_worst = candidate_worst;
+        }
+      }
+    }
+
+    std::vector<std::pair<worst_action, sequence>> ranked;
+    for (const auto &entry : worst_by_kind) ranked.push_back(entry.second);
+    std::sort(ranked.begin(), ranked.end(), [](const auto &x, const auto &y) { return x.first.cost > y.first.cost; });
+
+    std::printf("most expensive action found of each kind:\n");
+    for (const auto &entry : ranked) {
+      std::printf("  %-14s %8llu%s\n", entry.first.kind.c_str(), (unsigned long long)entry.first.cost,
+        entry.first.failure.empty() ? "" : "  (failed)");
+    }
+
+    bool over_limit = false;
+    for (size_t i = 0; i < ranked.size(); i++) {
+      bool over = opt.limit > 0 && ranked[i].first.cost > opt.limit;
+      over_limit = over_limit || over;
+      if (int(i) >= opt.top && !over) continue;
+
+      sequence reproducer = shrink(ranked[i].second, ranked[i].first);
+      worst_action w = evaluate(reproducer);
+      std::printf("\n# %s costs %llu%s%s\n", w.kind.c_str(), (unsigned long long)w.cost, over ? ", over the limit" : "",
+        w.failure.empty() ? "" : (", failing with: " + w.failure).c_str());
+      print_sequence(reproducer);
+    }
+
+    return over_limit ? 1 : 0;
+  }
+
+  static void print_sequence(const sequence &steps) {
+    std::printf("# advance kind a b repeat\n");
+    for (const step &s : steps) std::printf("%u %s %u %u %u\n", s.advance, s.kind.c_str(), s.a, s.b, s.repeat);
+  }
+
+private:
+  worst_action evaluate(const sequence &steps) {
+    worst_action w = run.run(steps);
+    auto &best = worst_by_kind[w.kind];
+    if (!w.kind.empty() && w.cost > best.first.cost) best = {w, steps};
+    return w;
+  }
+
+  uint32_t random_repeat() {
+    // mostly small, sometimes up to the scale
+    std::uniform_real_distribution<double> u(0, 1);
+    return std::max(1u, uint32_t(std::pow(double(opt.scale), u(rng) * u(rng) + 0.0)));
+  }
+
+  step random_step() {
+    std::uniform_int_distribution<size_t> kind(0, STEP_KINDS.size() - 1);
+    std::uniform_int_distribution<uint32_t> small(0, 31);
+    std::uniform_int_distribution<uint32_t> advance(0, 3);
+    static const uint32_t ADVANCES[] = {0, 10, 61, AUCTION_PERIOD_SECS};
+    return {ADVANCES[advance(rng)], STEP_KINDS[kind(rng)], small(rng), small(rng), random_repeat()};
+  }
+
+  sequence random_sequence() {
+    sequence steps;
+    for (int i = 0; i < opt.steps; i++) steps.push_back(random_step());
+    return steps;
+  }
+
+  sequence mutate(sequence steps) {
+    std::uniform_int_distribution<int> operation(0, 6);
+    auto position = [&](size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(rng); };
+
+    switch (steps.empty() ? 0 : operation(rng)) {
+      case 0:
+        steps.insert(steps.begin() + std::ptrdiff_t(steps.empty() ? 0 : position(steps.size() + 1)), random_step());
+        break;
+      case 1:
+        if (steps.size() > 1) steps.erase(steps.begin() + std::ptrdiff_t(position(steps.size())));
+        break;
+      case 2: {
+        size_t i = position(steps.size());
+        steps.insert(steps.begin() + std::ptrdiff_t(i), steps[i]);
+        break;
+      }
+      case 3:
+        steps[position(steps.size())] = random_step();
+        break;
+      case 4: {
+        step &s = steps[position(steps.size())];
+        s.repeat = std::min(opt.scale, s.repeat * 2);
+        break;
+      }
+      case 5: {
+        step &s = steps[position(steps.size())];
+        s.repeat = std::max(1u, s.repeat / 2);
+        break;
+      }
+      default: {
+        step &s = steps[position(steps.size())];
+        s.a = std::uniform_int_distribution<uint32_t>(0, 31)(rng);
+        s.b = std::uniform_int_distribution<uint32_t>(0, 31)(rng);
+        break;
+      }
+    }
+    return steps;
+  }
+
+  // the shortest sequence found whose most expensive action costs at least as much as the given one
+  sequence shrink(sequence steps, const worst_action &target) {
+    auto keeps = [&](const sequence &candidate) { return run.run(candidate).cost >= target.cost; };
+
+    steps.resize(target.step + 1);
+    bool changed = true;
+    while (changed) {
+      changed = false;
+
+      for (size_t i = steps.size(); i-- > 0;) {
+        if (steps.size() == 1) break;
+        sequence candidate = steps;
+        candidate.erase(candidate.begin() + std::ptrdiff_t(i));
+        if (keeps(candidate)) {
+          steps = candidate;
+          changed = true;
+        }
+      }
+
+      for (size_t i = 0; i < steps.size(); i++) {
+        // the lowest repeat count that keeps the cost, by bisection
+        uint32_t low = 1, high = steps[i].repeat;
+        while (low < high) {
+          sequence candidate = steps;
+          candidate[i].repeat = (low + high) / 2;
+          if (keeps(candidate)) high = candidate[i].repeat;
+          else low = candidate[i].repeat + 1;
+        }
+        if (high < steps[i].repeat) {
+          steps[i].repeat = high;
+          changed = true;
+        }
+
+        if (steps[i].advance > 0) {
+          sequence candidate = steps;
+          candidate[i].advance = 0;
+          if (keeps(candidate)) {
+            steps = candidate;
+            changed = true;
+          }
+        }
+      }
+    }
+    return steps;
+  }
+};
+
+
+sequence read_sequence(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("cannot read " + path);
+
+  sequence steps;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream fields(line);
+    step s;
+    if (!(fields >> s.advance >> s.kind >> s.a >> s.b >> s.repeat)) throw std::runtime_error("invalid step: " + line);
+    if (std::find(STEP_KINDS.begin(), STEP_KINDS.end(), s.kind) == STEP_KINDS.end()) {
+      throw std::runtime_error("unknown kind of step: " + s.kind);
+    }
+    steps.push_back(s);
+  }
+  return steps;
+}
+
+
+int replay(const options &opt, const std::string &path) {
+  runner run(opt.rank);
+  run.trace = [](const std::string &kind, uint64_t cost, const std::string &failure) {
+    std::printf("%-14s %8llu%s%s\n", kind.c_str(), (unsigned long long)cost, failure.empty() ? "" : "  failed: ",
+      failure.c_str());
+  };
+  worst_action w = run.run(read_sequence(path));
+  std::printf("most expensive: %s, %llu\n", w.kind.c_str(), (unsigned long long)w.cost);
+  return (opt.limit > 0 && w.cost > opt.limit) ? 1 : 0;
+}
+
+
+// the costs of the actions of one kind in a sequence, in the order they ran
+std::vector<uint64_t> action_costs(runner &run, const sequence &steps, const std::string &kind) {
+  std::vector<uint64_t> found;
+  std::string failed;
+  run.trace = [&](const std::string &k, uint64_t cost, const std::string &failure) {
+    if (k != kind) return;
+    if (!failure.empty() && failed.empty()) failed = failure;
+    found.push_back(cost);
+  };
+  run.run(steps);
+  run.trace = nullptr;
+  if (!failed.empty()) throw std::runtime_error("a " + kind + " action failed: " + failed);
+  return found;
+}
+
+sequence operator+(sequence first, const sequence &second) {
+  first.insert(first.end(), second.begin(), second.end());
+  return first;
+}
+
+int64_t per_row(uint64_t more, uint64_t fewer, uint64_t rows) {
+  return std::llround((double(more) - double(fewer)) / double(rows));
+}
+
+
+// prints the database operations of the action paths that cronacle_simulator models, as its DB_OPS_*
+// constants. Each path is run on a small state in which every bidder has deposited credit before bidding; the
+// costs that grow with a table are measured at two sizes and given as a fixed part and a part per row
+int costs() {
+  runner run(rank_by::dbops);
+  const uint32_t ROWS = 5;
+
+  // four bidders with credit, and an auction opened by the first of them, then bid on by the other three
+  sequence bidders = {{0, "deposit", 0, 0, 4}};
+  sequence auction = bidders + sequence{{0, "bid", 0, 0, 4}};
+  std::vector<uint64_t> bids = action_costs(run, auction, "bid");
+  uint64_t close_and_open = action_costs(run, auction + sequence{{AUCTION_PERIOD_SECS, "bid", 0, 1, 1}}, "bid").back();
+  uint64_t claim = action_costs(run, auction + sequence{{BID_PERIOD_SECS + 1, "claim", 0, 0, 1}}, "claim").back();
+
+  // bids sealed in the last 10 seconds of bidding, settled by the bid that opens the next auction
+  sequence sealed_setup = sequence{{0, "param", 0, 0, 1}, {0, "deposit", 0, 0, ROWS + 1}, {0, "bid", 0, 0, 1}};
+  auto sealed = [&](uint32_t count) {
+    sequence steps = sealed_setup;
+    if (count > 0) steps.push_back({BID_PERIOD_SECS - 5, "bid", 1, 0, count});
+    steps.push_back({count > 0 ? AUCTION_PERIOD_SECS - (BID_PERIOD_SECS - 5) : AUCTION_PERIOD_SECS, "bid", 0, 1, 1});
+    return action_costs(run, steps, "bid");
+  };
+  std::vector<uint64_t> sealed_bids = sealed(ROWS);
+  uint64_t settle_none = sealed(0).back(), settle_one = sealed(1).back(), settle_rows = sealed_bids.back();
+
+  // pre-bids on the second nft, applied by the bid that closes the first auction and opens its auction
+  std::vector<uint64_t> prebids = action_costs(run, {{0, "prebid", 10, 0, ROWS}}, "prebid");
+  auto opening = [&](uint32_t count) {
+    sequence steps = auction;
+    if (count > 0) steps.push_back({0, "prebid", 10, 0, count});
+    steps.push_back({AUCTION_PERIOD_SECS, "bid", 0, 1, 1});
+    return action_costs(run, steps, "bid").back();
+  };
+  uint64_t open_none = opening(0), open_three = opening(3), open_rows = opening(ROWS);
+  int64_t clear_prebid = per_row(open_rows, open_three, ROWS - 3);
+
+  std::printf("// database operations of each action path, from cronacle_explorer costs\n");
+  std::printf("const int DB_OPS_OPEN_BID = %llu;\n", (unsigned long long)bids[0]);
+  std::printf("const int DB_OPS_BID = %llu;\n", (unsigned long long)bids[3]);
+  std::printf("const int DB_OPS_CLOSE_AND_OPEN = %llu;\n", (unsigned long long)close_and_open);
+  std::printf("const int DB_OPS_CLAIM = %llu;\n", (unsigned long long)claim);
+  std::printf("const int DB_OPS_SEALED_BID = %llu;\n", (unsigned long long)sealed_bids[1]);
+  std::printf("const int DB_OPS_SEALED_BID_PER_ROW = %lld;\n", (long long)per_row(sealed_bids[ROWS], sealed_bids[1], ROWS - 1));
+  std::printf("const int DB_OPS_SETTLE_SEALED = %lld;\n", (long long)settle_one - (long long)settle_none);
+  std::printf("const int DB_OPS_SETTLE_SEALED_PER_ROW = %lld;\n", (long long)per_row(settle_rows, settle_one, ROWS - 1));
+  std::printf("const int DB_OPS_PREBID = %llu;\n", (unsigned long long)prebids[0]);
+  std::printf("const int DB_OPS_PREBID_PER_ROW = %lld;\n", (long long)per_row(prebids[ROWS - 1], prebids[0], ROWS - 1));
+  std::printf("const int DB_OPS_APPLY_PREBID = %lld;\n", (long long)per_row(open_three, open_none, 3) - clear_prebid);
+  std::printf("const int DB_OPS_CLEAR_PREBID = %lld;\n", (long long)clear_prebid);
+  return 0;
+}
+
+
+int usage() {
+  std::cerr << "usage: cronacle_explorer [explore] [--rank dbops|intrinsics|blocks] [--rounds N] [--mutations N]\n"
+               "       [--steps N] [--scale N] [--limit N] [--top N] [--seed N]\n"
+               "       cronacle_explorer replay FILE [--rank dbops|intrinsics|blocks] [--limit N]\n"
+               "       cronacle_explorer costs\n";
+  return 2;
+}
+
+
+int main(int argc, char **argv) {
+  options opt;
+  std::string mode = "explore";
+  std::string file;
+  int first = 1;
+
+  if (argc > 1 && argv[1][0] != '-') {
+    mode = argv[1];
+    first = 2;
+    if (mode == "replay") {
+      if (argc < 3) return usage();
+      file = argv[2];
+      first = 3;
+    } else if (mode != "explore" && mode != "costs") {
+      return usage();
+    }
+  }
+
+  try {
+    for (int i = first; i < argc; i++) {
+      std::string arg = argv[i];
+      if (i + 1 >= argc) return usage();
+      std::string value = argv[++i];
+
+      if (arg == "--rank") {
+        if (value == "dbops") opt.rank = rank_by::dbops;
+        else if (value == "intrinsics") opt.rank = rank_by::intrinsics;
+        else if (value == "blocks") opt.rank = rank_by::blocks;
+        else return usage();
+      }
+      else if (arg == "--rounds") opt.rounds = std::stoi(value);
+      else if (arg == "--mutations") opt.mutations = std::stoi(value);
+      else if (arg == "--steps") opt.steps = std::stoi(value);
+      else if (arg == "--scale") opt.scale = uint32_t(std::stoul(value));
+      else if (arg == "--limit") opt.limit = std::stoull(value);
+      else if (arg == "--top") opt.top = std::stoi(value);
+      else if (arg == "--seed") opt.seed = std::stoull(value);
+      else return usage();
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "invalid option: " << e.what() << "\n";
+    return usage();
+  }
+
+  if (opt.rank == rank_by::blocks) {
+    runner probe(opt.rank);
+    probe.run({});
+    if (executed_blocks == 0) {
+      std::cerr << "ranking by blocks needs a build with -fsanitize-coverage=trace-pc\n";
+      return 2;
+    }
+  }
+
+  try {
+    if (mode == "replay") return replay(opt, file);
+    if (mode == "costs") return costs();
+    explorer e(opt);
+    return e.explore();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 2;
+  }
+}
@@ -0,0 +1,95 @@
+// cronacle_export writes the state of a running cronacle contract as a dump for tools/cronacle_snapshot, which
+// packs it into importstate chunks, so that a test or staging chain can be loaded with it.
+//
+// Build:  g++ -std=c++17 -O2 -o cronacle_export tools/cronacle_export.cpp
+// Usage:  cronacle_export HOST PORT CONTRACT > dump.txt
+//
+// The tables are read with the native client in cronacle_client.hpp. The users, credits and subaccounts tables
+// have a scope per account, and the auctions table a scope per season, so their scopes are listed with
+// /v1/chain/get_table_by_scope first. The dump holds the tables that importstate loads, in the order they are
+// loaded: the current auction's bids, pre-bids, sealed bids and bid histories, and the records derived from
+// the loaded ones (holders, totals, activity, principals, wins and the leaderboard), are not exported.
+
+#include "cronacle_client.hpp"
+
+#include <iostream>
+
+using namespace cronacle_client;
+
+// an amount in the dump format: with its precision and code, or its integer amount and - if it has no symbol
+std::string dump_asset(const asset &a) {
+  return (a.symbol == 0) ? std::to_string(a.amount) + " -" : a.to_string();
+}
+
+// an auctions table scope in the dump format: the season number, or - for the contract's scope
+std::string dump_scope(uint64_t scope, uint64_t contract) {
+  return (scope == contract) ? "-" : std::to_string(scope);
+}
+
+void export_tables(client &node, const std::string &contract, std::ostream &out) {
+  uint64_t contract_value = name_value(contract);
+  std::vector<std::string> self = {contract};
+
+  for (const auto &entry : node.scoped_rows<parameter_row>("parameters", self)) {
+    out << "parameters " << name_string(entry.second.paramname) << " " << entry.second.value << "\n";
+  }
+  for (const auto &entry : node.scoped_rows<admin_row>("admins", self)) {
+    out << "admins " << name_string(entry.second.account) << "\n";
+  }
+  for (const auto &entry : node.scoped_rows<system_row>("system", self)) {
+    const system_row &s = entry.second;
+    out << "system " << s.init << " " << s.usercount << " " << dump_asset(s.cls) << "\n";
+  }
+
+  for (const auto &entry : node.scoped_rows<user_row>("users", node.table_scopes("users"))) {
+    const user_row &u = entry.second;
+    out << "users " << name_string(u.account) << " " << u.time;
+    if (!u.principal.empty()) out << " " << u.principal;
+    out << "\n";
+  }
+  for (const auto &entry : node.scoped_rows<credit_row>("credits", node.table_scopes("credits"))) {
+    out << "credits " << name_string(name_value(entry.first)) << " " << dump_asset(entry.second.amount) << "\n";
+  }
+
+  for (const auto &entry : node.scoped_rows<custodian_row>("custodians", self)) {
+    const custodian_row &c = entry.second;
+    out << "custodians " << name_string(c.account) << " " << dump_asset(c.held) << " " << c.bid_subaccount << " "
+        << c.bid_nftid << " " << dump_asset(c.bid_amount) << "\n";
+  }
+  for (const auto &entry : node.scoped_rows<subaccount_row>("subaccounts", node.table_scopes("subaccounts"))) {
+    out << "subaccounts " << name_string(name_value(entry.first)) << " " << entry.second.id << " "
+        << dump_asset(entry.second.amount) << "\n";
+  }
+
+  for (const auto &entry : node.scoped_rows<nft_row>("nfts", self)) {
+    out << "nfts " << entry.second.number << " " << entry.second.nftid;
+    for (uint64_t member : entry.second.bundle) out << " " << member;
+    out << "\n";
+  }
+
+  for (const auto &entry : node.scoped_rows<auction_head_row>("auctionhead", self)) {
+    out << "auctionhead " << entry.second.number << " " << dump_scope(entry.second.scope, contract_value) << "\n";
+  }
+  for (const auto &entry : node.scoped_rows<auction_row>("auctions", node.table_scopes("auctions"))) {
+    const auction_row &a = entry.second;
+    out << "auctions " << dump_scope(name_value(entry.first), contract_value) << " " << a.number << " " << a.nftid
+        << " " << a.start << " " << a.bidding_end << " " << a.end << " " << (a.winner != 0 ? name_string(a.winner) : "-")
+        << " " << dump_asset(a.bidamount) << "\n";
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc != 4) {
+    std::cerr << "usage: cronacle_export HOST PORT CONTRACT > dump.txt\n";
+    return 2;
+  }
+
+  try {
+    client node(argv[1], argv[2], argv[3]);
+    export_tables(node, argv[3], std::cout);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
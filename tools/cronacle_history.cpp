@@ -0,0 +1,631 @@
+// cronacle_history keeps a local, append-only history of settled auctions and bids in a memory-mapped columnar
+// store, and answers analytics queries over it without going back to the node.
+//
+// Build:  g++ -std=c++17 -O3 -march=native -o cronacle_history tools/cronacle_history.cpp
+// Usage:  cronacle_history DIR sync HOST PORT CONTRACT
+//         cronacle_history DIR append < records.txt
+//         cronacle_history DIR stats [filters]
+//         cronacle_history DIR curve SECONDS [filters]
+//         cronacle_history DIR winners [N] [filters]
+//         cronacle_history DIR resales [filters]
+//         cronacle_history DIR bidders [N] [filters]
+//
+// sync reads the auctions that settled since the last sync, and their bids, using the native client in
+// cronacle_client.hpp. The bids come from each auction's bid history ring, which holds its last BID_HISTORY_SLOTS
+// (16) bids, so the earlier bids of an auction with more bids are not in the store. Bid times are the auction's
+// start plus the whole seconds the ring records. Auctions that ended unsold are stored with no winner and an
+// amount of 0. append loads records from another source, one per line:
+//
+//   auction <number> <nftid> <start> <end> <winner or -> <amount> <code>
+//   bid     <auction> <time> <bidder> <nftid> <amount> <code>
+//
+// with times in microseconds since the epoch and amounts written with the currency's precision; an unsold
+// auction's amount may be 0 with any code. Auctions must arrive in increasing number order and bids in increasing
+// auction order; records of auctions already in the store are skipped.
+//
+// Filters restrict the rows a query reads:
+//
+//   --from T, --to T   auction end or bid time, seconds since the epoch, from inclusive and to exclusive
+//   --nft ID           one nft
+//   --account NAME     the winner of an auction, or the bidder of a bid
+//   --min AMOUNT       the clearing price or bid amount, in currency units
+//
+// stats prints the count, total, mean, min and max clearing price; curve prints the same per time bucket of
+// SECONDS; winners prints the N accounts that won most often; resales prints the nfts sold more than once with
+// their prices in order; bidders prints the N accounts that bid most often.
+//
+// Each column of each table is a file of fixed-width little-endian values, e.g. auctions.amount holds one int64
+// per auction. The file "meta" records the committed row count of each table and the currency symbol. An append
+// writes the new values at the end of every column and then replaces meta, so values past the committed count
+// are the remains of an interrupted append and are overwritten by the next one. Queries map the columns
+// read-only and scan them in blocks: each filter narrows a selection vector for the block, and the aggregates
+// read only the selected rows.
+
+#include "cronacle_client.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace cronacle_client;
+
+// rows per block of a scan
+const size_t SCAN_BLOCK = 4096;
+
+
+// COLUMN FILES
+
+struct column_spec {
+  const char *name;
+  size_t      width;
+};
+
+// the columns of each table, in the order the values of a record are written
+const std::vector<column_spec> AUCTION_COLUMNS = {
+  {"number", 4}, {"nftid", 8}, {"start", 8}, {"end", 8}, {"winner", 8}, {"amount", 8}};
+const std::vector<column_spec> BID_COLUMNS = {
+  {"auction", 4}, {"time", 8}, {"bidder", 8}, {"nftid", 8}, {"amount", 8}};
+
+struct store_meta {
+  uint64_t auctions = 0;   // committed rows
+  uint64_t bids = 0;
+  uint64_t symbol = 0;     // 0 until the first record is stored
+};
+
+std::string column_path(const std::string &dir, const std::string &table, const char *column) {
+  return dir + "/" + table + "." + column;
+}
+
+void fail(const std::string &what) {
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+store_meta read_meta(const std::string &dir) {
+  store_meta meta;
+  FILE *f = std::fopen((dir + "/meta").c_str(), "r");
+  if (f == nullptr) return meta;   // a new store
+
+  char key[16];
+  unsigned long long value;
+  while (std::fscanf(f, "%15s %llu", key, &value) == 2) {
+    if (std::strcmp(key, "auctions") == 0) meta.auctions = value;
+    else if (std::strcmp(key, "bids") == 0) meta.bids = value;
+    else if (std::strcmp(key, "symbol") == 0) meta.symbol = value;
+  }
+  std::fclose(f);
+  return meta;
+}
+
+// replaces meta in one rename, which commits the rows appended before it
+void write_meta(const std::string &dir, const store_meta &meta) {
+  std::string temp = dir + "/meta.tmp";
+  FILE *f = std::fopen(temp.c_str(), "w");
+  if (f == nullptr) fail(temp);
+  std::fprintf(f, "auctions %llu\nbids %llu\nsymbol %llu\n", (unsigned long long)meta.auctions,
+               (unsigned long long)meta.bids, (unsigned long long)meta.symbol);
+  std::fflush(f);
+  fsync(fileno(f));
+  std::fclose(f);
+  if (std::rename(temp.c_str(), (dir + "/meta").c_str()) != 0) fail(dir + "/meta");
+}
+
+// appends rows to the columns of a table, packed column by column, after the committed rows
+void append_columns(const std::string &dir, const std::string &table, const std::vector<column_spec> &columns,
+                    uint64_t committed, const std::vector<std::vector<uint8_t>> &values) {
+  for (size_t c = 0; c < columns.size(); c++) {
+    std::string path = column_path(dir, table, columns[c].name);
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd < 0) fail(path);
+
+    off_t offset = off_t(committed * columns[c].width);
+    if (ftruncate(fd, offset) != 0) fail(path);
+
+    const uint8_t *data = values[c].data();
+    size_t left = values[c].size();
+    while (left > 0) {
+      ssize_t written = pwrite(fd, data, left, offset);
+      if (written < 0) fail(path);
+      data += written;
+      offset += written;
+      left -= size_t(written);
+    }
+    if (fsync(fd) != 0) fail(path);
+    close(fd);
+  }
+}
+
+// a read-only mapping of one column, limited to the committed rows
+template<typename T>
+class column {
+  const T *data = nullptr;
+  size_t   rows = 0;
+  size_t   mapped = 0;
+
+public:
+  column(const std::string &path, uint64_t committed) : rows(committed) {
+    if (rows == 0) return;
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) fail(path);
+    mapped = rows * sizeof(T);
+    void *p = mmap(nullptr, mapped, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) fail(path);
+    madvise(p, mapped, MADV_SEQUENTIAL);
+    data = static_cast<const T *>(p);
+  }
+
+  ~column() {
+    if (data != nullptr) munmap(const_cast<T *>(data), mapped);
+  }
+
+  column(const column &) = delete;
+  column &operator=(const column &) = delete;
+
+  const T *begin() const { return data; }
+  size_t size() const { return rows; }
+  T operator[](size_t i) const { return data[i]; }
+};
+
+
+// APPENDING
+
+void put(std::vector<uint8_t> &out, uint64_t value, size_t width) {
+  for (size_t i = 0; i < width; i++) out.push_back(uint8_t(value >> (8 * i)));
+}
+
+// records waiting to be appended, one byte vector per column
+struct pending_rows {
+  std::vector<std::vector<uint8_t>> auctions = std::vector<std::vector<uint8_t>>(AUCTION_COLUMNS.size());
+  std::vector<std::vector<uint8_t>> bids = std::vector<std::vector<uint8_t>>(BID_COLUMNS.size());
+  uint64_t auction_count = 0;
+  uint64_t bid_count = 0;
+};
+
+// the last stored auction number and the auction of the last stored bid, so that records already in the store
+// are skipped. The bids of one auction arrive together, so bids are skipped by auction rather than by time
+struct store_tail {
+  int64_t last_auction = -1;
+  int64_t stored_bid_auction = -1;    // committed
+  int64_t pending_bid_auction = -1;   // the auction of the last bid of this append
+};
+
+store_tail read_tail(const std::string &dir, const store_meta &meta) {
+  store_tail tail;
+  if (meta.auctions > 0) {
+    column<uint32_t> number(column_path(dir, "auctions", "number"), meta.auctions);
+    tail.last_auction = number[number.size() - 1];
+  }
+  if (meta.bids > 0) {
+    column<uint32_t> auction(column_path(dir, "bids", "auction"), meta.bids);
+    tail.stored_bid_auction = auction[auction.size() - 1];
+    tail.pending_bid_auction = tail.stored_bid_auction;
+  }
+  return tail;
+}
+
+void check_symbol(store_meta &meta, const asset &amount) {
+  if (meta.symbol == 0) meta.symbol = amount.symbol;
+  if (amount.symbol != meta.symbol) throw std::runtime_error("the record's currency differs from the store's");
+}
+
+void add_auction(pending_rows &rows, store_meta &meta, store_tail &tail, const auction_row &a) {
+  if (int64_t(a.number) <= tail.last_auction) return;
+  // an unsold auction's amount has no symbol
+  if (a.winner != 0) check_symbol(meta, a.bidamount);
+
+  uint64_t values[] = {a.number, a.nftid, uint64_t(a.start), uint64_t(a.end), a.winner,
+    uint64_t(a.winner != 0 ? a.bidamount.amount : 0)};
+  for (size_t c = 0; c < AUCTION_COLUMNS.size(); c++) put(rows.auctions[c], values[c], AUCTION_COLUMNS[c].width);
+  rows.auction_count++;
+  tail.last_auction = a.number;
+}
+
+void add_bid(pending_rows &rows, store_meta &meta, store_tail &tail, uint32_t auction, const bid_row &b) {
+  if (int64_t(auction) <= tail.stored_bid_auction || int64_t(auction) < tail.pending_bid_auction) return;
+  check_symbol(meta, b.bidamount);
+
+  uint64_t values[] = {auction, uint64_t(b.bidtime), b.bidder, b.nftid, uint64_t(b.bidamount.amount)};
+  for (size_t c = 0; c < BID_COLUMNS.size(); c++) put(rows.bids[c], values[c], BID_COLUMNS[c].width);
+  rows.bid_count++;
+  tail.pending_bid_auction = auction;
+}
+
+void commit(const std::string &dir, store_meta &meta, const pending_rows &rows) {
+  if (rows.auction_count > 0) append_columns(dir, "auctions", AUCTION_COLUMNS, meta.auctions, rows.auctions);
+  if (rows.bid_count > 0) append_columns(dir, "bids", BID_COLUMNS, meta.bids, rows.bids);
+
+  meta.auctions += rows.auction_count;
+  meta.bids += rows.bid_count;
+  write_meta(dir, meta);
+
+  std::cout << "appended " << rows.auction_count << " auctions and " << rows.bid_count << " bids\n";
+}
+
+// parses an amount such as 12.3456 and a code into an asset
+asset parse_asset(const std::string &amount, const std::string &code) {
+  asset a;
+  size_t point = amount.find('.');
+  std::string digits = amount;
+  uint8_t precision = 0;
+  if (point != std::string::npos) {
+    precision = uint8_t(amount.size() - point - 1);
+    digits.erase(point, 1);
+  }
+  a.amount = std::stoll(digits);
+  a.symbol = precision;
+  for (size_t i = 0; i < code.size(); i++) a.symbol |= uint64_t(uint8_t(code[i])) << (8 * (i + 1));
+  return a;
+}
+
+void sync(const std::string &dir, const std::string &host, const std::string &port, const std::string &contract) {
+  store_meta meta = read_meta(dir);
+  store_tail tail = read_tail(dir, meta);
+  pending_rows rows;
+  client node(host, port, contract);
+
+  // auctions after the last stored one, oldest first. Every auction but the newest has been settled, and the
+  // newest only once it has a winner
+  uint32_t last_number = (tail.last_auction < 0) ? 0 : uint32_t(tail.last_auction);
+  std::vector<auction_row> auctions = node.auctions_after(last_number);
+  if (!auctions.empty() && auctions.back().winner == 0) auctions.pop_back();
+
+  std::map<uint32_t, const auction_row *> stored;
+  for (const auto &a : auctions) {
+    add_auction(rows, meta, tail, a);
+    stored[a.number] = &a;
+  }
+
+  // the bids of the stored auctions, from their bid history rings in one range query
+  if (!stored.empty()) {
+    std::vector<bid_history_row> histories = node.bid_histories(stored.begin()->first, stored.rbegin()->first);
+    for (const auto &h : histories) {
+      // the bids of an auction with a winner, whose amount has given the store its symbol
+      auto settled = stored.find(h.number);
+      if (settled == stored.end() || settled->second->winner == 0) continue;
+
+      bid_row b;
+      b.nftid = settled->second->nftid;
+      b.bidamount.symbol = meta.symbol;
+      for (size_t i = 0; i < h.slots.size(); i++) {
+        const bid_slot &slot = h.slots[(h.head + i) % h.slots.size()];
+        if (slot.bidder == 0) continue;
+        b.bidtime = settled->second->start + int64_t(slot.offset) * 1000000;
+        b.bidder = slot.bidder;
+        b.bidamount.amount = int64_t(slot.amount);
+        add_bid(rows, meta, tail, h.number, b);
+      }
+    }
+  }
+
+  commit(dir, meta, rows);
+}
+
+void append(const std::string &dir) {
+  store_meta meta = read_meta(dir);
+  store_tail tail = read_tail(dir, meta);
+  pending_rows rows;
+
+  std::string line;
+  size_t line_number = 0;
+  while (std::getline(std::cin, line)) {
+    line_number++;
+    std::istringstream fields(line);
+    std::string kind;
+    if (!(fields >> kind) || kind[0] == '#') continue;
+
+    try {
+      if (kind == "auction") {
+        std::string number, nftid, start, end, winner, amount, code;
+        if (!(fields >> number >> nftid >> start >> end >> winner >> amount >> code)) throw std::runtime_error("missing fields");
+        auction_row a;
+        a.number = uint32_t(std::stoul(number));
+        a.nftid = std::stoull(nftid);
+        a.start = std::stoll(start);
+        a.bidding_end = 0;
+        a.end = std::stoll(end);
+        a.winner = (winner == "-") ? 0 : name_value(winner);
+        a.bidamount = parse_asset(amount, code);
+        add_auction(rows, meta, tail, a);
+      } else if (kind == "bid") {
+        std::string auction, time, bidder, nftid, amount, code;
+        if (!(fields >> auction >> time >> bidder >> nftid >> amount >> code)) throw std::runtime_error("missing fields");
+        bid_row b;
+        b.bidtime = std::stoll(time);
+        b.bidder = name_value(bidder);
+        b.nftid = std::stoull(nftid);
+        b.bidamount = parse_asset(amount, code);
+        add_bid(rows, meta, tail, uint32_t(std::stoul(auction)), b);
+      } else {
+        throw std::runtime_error("unknown record " + kind);
+      }
+    } catch (const std::exception &e) {
+      throw std::runtime_error("line " + std::to_string(line_number) + ": " + e.what());
+    }
+  }
+
+  commit(dir, meta, rows);
+}
+
+
+// QUERIES
+
+struct filters {
+  int64_t  from = INT64_MIN;    // microseconds
+  int64_t  to = INT64_MAX;
+  bool     by_nft = false;
+  uint64_t nft = 0;
+  bool     by_account = false;
+  uint64_t account = 0;
+  int64_t  min_amount = INT64_MIN;
+  std::string min_text;         // converted once the store's precision is known
+};
+
+// the rows of one table that a query reads
+struct table_view {
+  const int64_t  *time;         // auction end or bid time
+  const uint64_t *nftid;
+  const uint64_t *account;      // winner or bidder
+  const int64_t  *amount;
+  size_t          rows;
+};
+
+/**
+ * scan function runs a query over a table, one block of rows at a time. The filters narrow a selection vector of
+ * row numbers for the block, the time filter over the whole block and each further filter over the rows still
+ * selected, and the visitor is called with the selected rows of each block.
+ *
+ * @param view the columns of the table
+ * @param f the filters of the query
+ * @param visit called with the selected row numbers of a block and their count
+ */
+template<typename Visitor>
+void scan(const table_view &view, const filters &f, Visitor &&visit) {
+  uint32_t selected[SCAN_BLOCK];
+
+  for (size_t base = 0; base < view.rows; base += SCAN_BLOCK) {
+    size_t block = std::min(SCAN_BLOCK, view.rows - base);
+    const int64_t *time = view.time + base;
+
+    // branch-free: every row is written, and the count only moves past the ones that match
+    size_t count = 0;
+    for (size_t i = 0; i < block; i++) {
+      selected[count] = uint32_t(base + i);
+      count += (time[i] >= f.from) & (time[i] < f.to);
+    }
+
+    auto narrow = [&](auto &&keep) {
+      size_t kept = 0;
+      for (size_t i = 0; i < count; i++) {
+        uint32_t row = selected[i];
+        selected[kept] = row;
+        kept += keep(row) ? 1 : 0;
+      }
+      count = kept;
+    };
+
+    if (f.by_nft) narrow([&](uint32_t row) { return view.nftid[row] == f.nft; });
+    if (f.by_account) narrow([&](uint32_t row) { return view.account[row] == f.account; });
+    if (f.min_amount != INT64_MIN) narrow([&](uint32_t row) { return view.amount[row] >= f.min_amount; });
+
+    if (count > 0) visit(selected, count);
+  }
+}
+
+struct amount_stats {
+  uint64_t count = 0;
+  int64_t  total = 0;
+  int64_t  min = INT64_MAX;
+  int64_t  max = INT64_MIN;
+
+  void add(int64_t amount) {
+    count++;
+    total += amount;
+    min = std::min(min, amount);
+    max = std::max(max, amount);
+  }
+};
+
+std::string format_amount(int64_t amount, uint64_t symbol) {
+  asset a;
+  a.amount = amount;
+  a.symbol = symbol;
+  return a.to_string();
+}
+
+void print_stats(const amount_stats &s, uint64_t symbol) {
+  std::cout << s.count;
+  if (s.count > 0) {
+    std::cout << " total " << format_amount(s.total, symbol) << " mean " << format_amount(s.total / int64_t(s.count), symbol)
+              << " min " << format_amount(s.min, symbol) << " max " << format_amount(s.max, symbol);
+  }
+  std::cout << "\n";
+}
+
+// the store's columns for one query. Auction times are the end of the auction
+class store_reader {
+public:
+  store_meta meta;
+  column<int64_t>  auction_end;
+  column<uint64_t> auction_nftid;
+  column<uint64_t> auction_winner;
+  column<int64_t>  auction_amount;
+  column<int64_t>  bid_time;
+  column<uint64_t> bid_nftid;
+  column<uint64_t> bid_bidder;
+  column<int64_t>  bid_amount;
+
+  store_reader(const std::string &dir, const store_meta &m) :
+    meta(m),
+    auction_end(column_path(dir, "auctions", "end"), m.auctions),
+    auction_nftid(column_path(dir, "auctions", "nftid"), m.auctions),
+    auction_winner(column_path(dir, "auctions", "winner"), m.auctions),
+    auction_amount(column_path(dir, "auctions", "amount"), m.auctions),
+    bid_time(column_path(dir, "bids", "time"), m.bids),
+    bid_nftid(column_path(dir, "bids", "nftid"), m.bids),
+    bid_bidder(column_path(dir, "bids", "bidder"), m.bids),
+    bid_amount(column_path(dir, "bids", "amount"), m.bids) {}
+
+  table_view auctions() const {
+    return {auction_end.begin(), auction_nftid.begin(), auction_winner.begin(), auction_amount.begin(), auction_end.size()};
+  }
+
+  table_view bids() const {
+    return {bid_time.begin(), bid_nftid.begin(), bid_bidder.begin(), bid_amount.begin(), bid_time.size()};
+  }
+};
+
+// prints the accounts that appear most often in the selected rows, with their total amount
+void print_top_accounts(const table_view &view, const filters &f, size_t n, uint64_t symbol) {
+  std::unordered_map<uint64_t, amount_stats> by_account;
+  scan(view, f, [&](const uint32_t *rows, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      uint64_t account = view.account[rows[i]];
+      if (account != 0) by_account[account].add(view.amount[rows[i]]);
+    }
+  });
+
+  std::vector<std::pair<uint64_t, amount_stats>> ranked(by_account.begin(), by_account.end());
+  std::sort(ranked.begin(), ranked.end(), [](const auto &a, const auto &b) {
+    return a.second.count != b.second.count ? a.second.count > b.second.count : a.first < b.first;
+  });
+  if (ranked.size() > n) ranked.resize(n);
+
+  for (const auto &entry : ranked) {
+    std::cout << name_string(entry.first) << " ";
+    print_stats(entry.second, symbol);
+  }
+}
+
+int query(const std::string &dir, const std::string &command, std::vector<std::string> args) {
+  store_meta meta = read_meta(dir);
+  store_reader store(dir, meta);
+
+  // positional arguments come before the filters
+  std::vector<std::string> positional;
+  while (!args.empty() && args.front().compare(0, 2, "--") != 0) {
+    positional.push_back(args.front());
+    args.erase(args.begin());
+  }
+
+  filters f;
+  for (size_t i = 0; i + 1 < args.size(); i += 2) {
+    const std::string &flag = args[i], &value = args[i + 1];
+    if (flag == "--from") f.from = std::stoll(value) * 1000000;
+    else if (flag == "--to") f.to = std::stoll(value) * 1000000;
+    else if (flag == "--nft") { f.by_nft = true; f.nft = std::stoull(value); }
+    else if (flag == "--account") { f.by_account = true; f.account = name_value(value); }
+    else if (flag == "--min") f.min_text = value;
+    else throw std::runtime_error("unknown filter " + flag);
+  }
+  if (args.size() % 2 != 0) throw std::runtime_error("filter " + args.back() + " has no value");
+
+  if (!f.min_text.empty()) {
+    int64_t scale = 1;
+    for (uint8_t p = uint8_t(meta.symbol & 0xff); p > 0; p--) scale *= 10;
+    f.min_amount = int64_t(std::stod(f.min_text) * double(scale) + 0.5);
+  }
+
+  if (command == "stats") {
+    amount_stats s;
+    table_view view = store.auctions();
+    scan(view, f, [&](const uint32_t *rows, size_t count) {
+      for (size_t i = 0; i < count; i++) {
+        if (view.account[rows[i]] != 0) s.add(view.amount[rows[i]]);
+      }
+    });
+    std::cout << "sold ";
+    print_stats(s, meta.symbol);
+
+  } else if (command == "curve" && positional.size() == 1) {
+    int64_t bucket = std::stoll(positional[0]) * 1000000;
+    if (bucket <= 0) throw std::runtime_error("the bucket must be at least one second");
+
+    std::map<int64_t, amount_stats> curve;
+    table_view view = store.auctions();
+    scan(view, f, [&](const uint32_t *rows, size_t count) {
+      for (size_t i = 0; i < count; i++) {
+        uint32_t row = rows[i];
+        if (view.account[row] != 0) curve[view.time[row] / bucket * bucket].add(view.amount[row]);
+      }
+    });
+    for (const auto &entry : curve) {
+      std::cout << entry.first / 1000000 << " ";
+      print_stats(entry.second, meta.symbol);
+    }
+
+  } else if (command == "winners" || command == "bidders") {
+    size_t n = positional.empty() ? 10 : std::stoul(positional[0]);
+    print_top_accounts(command == "winners" ? store.auctions() : store.bids(), f, n, meta.symbol);
+
+  } else if (command == "resales") {
+    std::unordered_map<uint64_t, std::vector<int64_t>> prices;
+    table_view view = store.auctions();
+    scan(view, f, [&](const uint32_t *rows, size_t count) {
+      for (size_t i = 0; i < count; i++) {
+        uint32_t row = rows[i];
+        if (view.account[row] != 0) prices[view.nftid[row]].push_back(view.amount[row]);
+      }
+    });
+
+    std::vector<uint64_t> resold;
+    for (const auto &entry : prices) {
+      if (entry.second.size() > 1) resold.push_back(entry.first);
+    }
+    std::sort(resold.begin(), resold.end());
+    for (uint64_t nftid : resold) {
+      std::cout << nftid;
+      for (int64_t price : prices[nftid]) std::cout << " " << format_amount(price, meta.symbol);
+      std::cout << "\n";
+    }
+
+  } else {
+    std::cerr << "unknown command " << command << "\n";
+    return 2;
+  }
+
+  return 0;
+}
+
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "usage: cronacle_history DIR sync HOST PORT CONTRACT | append | stats | curve SECONDS | winners [N]"
+                 " | resales | bidders [N] [--from T] [--to T] [--nft ID] [--account NAME] [--min AMOUNT]\n";
+    return 2;
+  }
+
+  std::string dir = argv[1];
+  std::string command = argv[2];
+
+  try {
+    if (command == "sync" || command == "append") {
+      if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) fail(dir);
+      if (command == "append") {
+        append(dir);
+      } else if (argc == 6) {
+        sync(dir, argv[3], argv[4], argv[5]);
+      } else {
+        std::cerr << "usage: cronacle_history DIR sync HOST PORT CONTRACT\n";
+        return 2;
+      }
+      return 0;
+    }
+
+    return query(dir, command, std::vector<std::string>(argv + 3, argv + argc));
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+}
@@ -0,0 +1,69 @@
+// cronacle_query prints the cronacle tables using the native client in cronacle_client.hpp.
+//
+// Build:  g++ -std=c++17 -O2 -o cronacle_query tools/cronacle_query.cpp
+// Usage:  cronacle_query HOST PORT CONTRACT credits USER...
+//         cronacle_query HOST PORT CONTRACT bids
+//         cronacle_query HOST PORT CONTRACT nfts
+//         cronacle_query HOST PORT CONTRACT parameters
+//         cronacle_query HOST PORT CONTRACT auctions COUNT [POLLS]
+//
+// With POLLS the auctions are read that many times over the same connection, so that settled auctions come from
+// the client's cache after the first read.
+
+#include "cronacle_client.hpp"
+
+#include <iostream>
+
+using namespace cronacle_client;
+
+int main(int argc, char **argv) {
+  if (argc < 5) {
+    std::cerr << "usage: cronacle_query HOST PORT CONTRACT credits USER... | bids | nfts | parameters | auctions COUNT [POLLS]\n";
+    return 2;
+  }
+
+  client node(argv[1], argv[2], argv[3]);
+  std::string command = argv[4];
+
+  try {
+    if (command == "credits") {
+      std::vector<std::string> users(argv + 5, argv + argc);
+      for (const auto &entry : node.credits(users)) {
+        std::cout << entry.first << " " << entry.second.to_string() << "\n";
+      }
+    } else if (command == "bids") {
+      for (const auto &b : node.bids()) {
+        std::cout << name_string(b.bidder) << " " << b.bidamount.to_string() << " nft " << b.nftid << " at " << b.bidtime << "\n";
+      }
+    } else if (command == "nfts") {
+      for (const auto &n : node.nfts()) {
+        std::cout << n.number << " " << n.nftid;
+        for (uint64_t id : n.bundle) std::cout << " +" << id;
+        std::cout << "\n";
+      }
+    } else if (command == "parameters") {
+      for (const auto &p : node.parameters()) {
+        std::cout << name_string(p.paramname) << " = " << p.value << "\n";
+      }
+    } else if (command == "auctions" && argc >= 6) {
+      uint32_t count = uint32_t(std::stoul(argv[5]));
+      int polls = (argc >= 7) ? std::stoi(argv[6]) : 1;
+
+      std::vector<auction_row> auctions;
+      for (int i = 0; i < polls; i++) auctions = node.latest_auctions(count);
+
+      for (const auto &a : auctions) {
+        std::cout << a.number << " nft " << a.nftid << " winner " << (a.winner ? name_string(a.winner) : "-")
+          << " " << a.bidamount.to_string() << " end " << a.end << "\n";
+      }
+    } else {
+      std::cerr << "unknown command " << command << "\n";
+      return 2;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,763 @@
+// cronacle_simulator runs synthetic auction seasons under the contract's auction rules (cronacle_rules.hpp) to
+// compare values of the auctperiod, bidperiod, minimumbid, bidstep and batchwindow parameters.
+//
+// Build:  g++ -std=c++17 -O2 -pthread -o cronacle_simulator tools/cronacle_simulator.cpp
+// Usage:  cronacle_simulator [options]
+//
+//   --auctperiod LIST   seconds, e.g. 3600,7200          (default 3600)
+//   --bidperiod LIST    seconds                          (default 1800)
+//   --minimumbid LIST   whole currency units             (default 1)
+//   --bidstep LIST      whole currency units             (default 1)
+//   --batchwindow LIST  seconds at the end of bidding in which bids are sealed, 0 for none (default 0)
+//   --seasons N         seasons per parameter set        (default 1000)
+//   --auctions N        auction slots per season         (default 24)
+//   --bidders N         bidders per season               (default 50)
+//   --interest P        chance that a bidder wants a given nft (default 0.3)
+//   --value V           mean value of an nft in currency units (default 20)
+//   --models LIST       bidder behaviour mix as name:weight, e.g. incremental:3,sniper:1 (default incremental:1)
+//   --latency S         seconds between a bidder reading the auction and the bid arriving (default 2)
+//   --claimdelay S      mean seconds after bidding ends before the winner claims (default 600)
+//   --prebid P          chance that a bidder who wants an nft pre-bids on it before its auction opens (default 0)
+//   --threads N         worker threads                   (default: all cores)
+//   --seed N            random seed                      (default 1)
+//
+// Every combination of the listed parameter values is simulated. For each one the simulator prints the
+// distribution (mean, p10, p50, p90) over auctions of accepted bid transactions, sealed bids, pre-bid
+// transactions, rejected bid attempts, database operations, clearing price and settlement delay, with the share
+// of slots that opened no auction and the revenue per season.
+//
+// Bids in the final batchwindow seconds are sealed as in the contract: bidders do not see them, and when the
+// auction is settled the highest sealed bid that beats the open bidding by the bidstep wins. Pre-bids are filed
+// at the start of the slot in which the nft is auctioned, for part of the bidder's value, and the three highest
+// become the opening bids when a bid opens the auction, which that bid must beat.
+//
+// Database operations stand in for CPU. The DB_OPS_* costs below are the output of `cronacle_explorer costs`
+// (tools/cronacle_explorer.cpp), which runs each path through the contract built with CRONACLE_DBTRACE, and
+// should be replaced with its output when the contract changes.
+//
+// Bidder behaviour models are classes derived from bidder_model, registered in model_registry().
+
+#include "../cronacle_rules.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// database operations of each action path, from cronacle_explorer costs
+const int DB_OPS_OPEN_BID = 34;                 // bid that opens an auction (open_first)
+const int DB_OPS_BID = 32;                      // bid on an open auction (add_bid)
+const int DB_OPS_CLOSE_AND_OPEN = 59;           // bid that settles the previous auction and opens the next one
+const int DB_OPS_CLAIM = 32;                    // claim by the winner
+const int DB_OPS_SEALED_BID = 24;               // bid sealed in the batchwindow
+const int DB_OPS_SEALED_BID_PER_ROW = 1;        // and for each sealed bid held, when the bidder has none
+const int DB_OPS_SETTLE_SEALED = 32;            // added to the settling claim or bid by the sealed bids
+const int DB_OPS_SETTLE_SEALED_PER_ROW = 16;    // and for each sealed bid after the first
+const int DB_OPS_PREBID = 14;                   // pre-bid
+const int DB_OPS_PREBID_PER_ROW = 1;            // and for each pre-bid held on the nft, when the bidder has none
+const int DB_OPS_APPLY_PREBID = 18;             // added to the opening bid for each pre-bid it applies
+const int DB_OPS_CLEAR_PREBID = 1;              // and for each pre-bid it deletes without applying
+
+// the contract's limits on the pre-bids on an nft, the pre-bids applied when its auction opens, and sealed bids
+const size_t MAX_PREBIDS = 20;
+const size_t APPLIED_PREBIDS = 3;
+const size_t MAX_SEALED_BIDS = 50;
+
+// seasons in one work item
+const int SEASONS_PER_TASK = 8;
+
+typedef std::mt19937_64 rng_t;
+
+
+struct parameter_set {
+  uint32_t auctperiod;
+  uint32_t bidperiod;
+  int64_t  minimumbid;
+  int64_t  bidstep;
+  uint32_t batchwindow;
+};
+
+struct options {
+  std::vector<parameter_set> sets;
+  int      seasons = 1000;
+  int      auctions = 24;
+  int      bidders = 50;
+  double   interest = 0.3;
+  double   value = 20;
+  double   latency = 2;
+  double   claimdelay = 600;
+  double   prebid = 0;
+  unsigned threads = 0;
+  uint64_t seed = 1;
+  std::vector<std::pair<std::string, double>> models = {{"incremental", 1}};
+};
+
+
+// what a bidder sees of the auction when deciding
+struct auction_view {
+  double  elapsed;        // seconds since bidding opened
+  double  bidperiod;
+  int64_t highest;        // highest bid, 0 if none
+  int64_t minimum_next;   // the lowest acceptable bid, going by the bidder's view
+  bool    leading;        // the bidder holds the highest bid
+};
+
+
+// bidder behaviour. Models are shared between threads, so they keep no state of their own
+class bidder_model {
+public:
+  virtual ~bidder_model() {}
+
+  // seconds into the bidding period at which the bidder first looks at the auction
+  virtual double first_look(rng_t &rng, double bidperiod) const = 0;
+
+  // the amount to bid, or 0 to stay out
+  virtual int64_t bid_amount(rng_t &rng, const auction_view &view, double value) const = 0;
+
+  // seconds until the bidder looks again, or a negative number to stop
+  virtual double next_look(rng_t &rng, const auction_view &view) const = 0;
+};
+
+// bids the minimum whenever outbid, until the price passes the bidder's value
+class incremental_model : public bidder_model {
+public:
+  double first_look(rng_t &rng, double bidperiod) const override {
+    return std::uniform_real_distribution<double>(0, bidperiod)(rng);
+  }
+
+  int64_t bid_amount(rng_t &, const auction_view &view, double value) const override {
+    if (view.leading || view.minimum_next > value) return 0;
+    return view.minimum_next;
+  }
+
+  double next_look(rng_t &rng, const auction_view &view) const override {
+    return std::exponential_distribution<double>(10.0 / view.bidperiod)(rng);
+  }
+};
+
+// bids its whole value once, in the last seconds of the bidding period
+class sniper_model : public bidder_model {
+public:
+  double first_look(rng_t &rng, double bidperiod) const override {
+    return bidperiod - std::uniform_real_distribution<double>(0, std::min(60.0, bidperiod / 10))(rng);
+  }
+
+  int64_t bid_amount(rng_t &, const auction_view &view, double value) const override {
+    int64_t amount = int64_t(std::floor(value));
+    return (amount >= view.minimum_next && !view.leading) ? amount : 0;
+  }
+
+  double next_look(rng_t &, const auction_view &) const override { return -1; }
+};
+
+// opens with a jump to part of its value, then bids like the incremental model
+class jump_model : public bidder_model {
+public:
+  double first_look(rng_t &rng, double bidperiod) const override {
+    return std::uniform_real_distribution<double>(0, bidperiod / 4)(rng);
+  }
+
+  int64_t bid_amount(rng_t &rng, const auction_view &view, double value) const override {
+    if (view.leading || view.minimum_next > value) return 0;
+    int64_t jump = int64_t(value * std::uniform_real_distribution<double>(0.5, 0.8)(rng));
+    return std::max(jump, view.minimum_next);
+  }
+
+  double next_look(rng_t &rng, const auction_view &view) const override {
+    return std::exponential_distribution<double>(10.0 / view.bidperiod)(rng);
+  }
+};
+
+std::map<std::string, std::function<std::unique_ptr<bidder_model>()>> &model_registry() {
+  static std::map<std::string, std::function<std::unique_ptr<bidder_model>()>> registry = {
+    {"incremental", [] { return std::unique_ptr<bidder_model>(new incremental_model()); }},
+    {"sniper", [] { return std::unique_ptr<bidder_model>(new sniper_model()); }},
+    {"jump", [] { return std::unique_ptr<bidder_model>(new jump_model()); }},
+  };
+  return registry;
+}
+
+
+// the outcome of one auction
+struct auction_result {
+  int     accepted = 0;
+  int     sealed = 0;
+  int     prebids = 0;
+  int     rejected = 0;
+  int     db_ops = 0;
+  int64_t price = 0;
+  double  settlement_delay = 0;
+};
+
+// the results of the seasons simulated for one parameter set
+struct set_results {
+  std::mutex lock;
+  std::vector<auction_result> auctions;
+  std::vector<double> revenue;
+  uint64_t slots = 0;
+  uint64_t empty_slots = 0;
+};
+
+
+class season {
+  const options &opt;
+  const parameter_set &p;
+  const std::vector<const bidder_model *> &models;
+  rng_t rng;
+
+  struct bidder {
+    const bidder_model *model;
+    double taste;   // multiplies the nft's common value
+  };
+
+  struct bid_attempt {
+    double  time;   // seconds since the epoch
+    size_t  bidder;
+  };
+
+  std::vector<bidder> bidders;
+  std::deque<uint64_t> queue;
+
+  // contract state
+  cronacle_rules::latest_auction latest = {false, 0, 0, 0, 0};
+  bool    settled = true;   // the latest auction has been settled
+  int64_t highest = 0;
+  size_t  leader = 0;
+  double  claim_time = 0;
+  auction_result current;
+  int     pending_rejected = 0;   // rejected attempts to open the next auction
+
+  // bids sealed in the batchwindow of the latest auction, and the pre-bids on the nft to be auctioned next, by bidder
+  struct held_bid {
+    int64_t amount;
+    double  time;
+  };
+  std::map<size_t, held_bid> sealed;
+  std::map<size_t, held_bid> prebids;
+  int     pending_prebids = 0;
+  int     pending_prebid_ops = 0;
+
+  std::vector<auction_result> &results;
+
+public:
+  uint64_t empty_slots = 0;
+  double   revenue = 0;
+
+  season(const options &o, const parameter_set &ps, const std::vector<const bidder_model *> &m, uint64_t seed,
+         std::vector<auction_result> &out) : opt(o), p(ps), models(m), rng(seed), results(out) {}
+
+  void run() {
+    const uint64_t init_secs = 1000000;
+
+    std::vector<double> weights;
+    for (const auto &m : opt.models) weights.push_back(m.second);
+    std::discrete_distribution<size_t> pick_model(weights.begin(), weights.end());
+    std::uniform_real_distribution<double> taste(0.5, 1.5);
+    for (int i = 0; i < opt.bidders; i++) {
+      bidders.push_back({models[pick_model(rng)], taste(rng)});
+    }
+
+    for (int i = 1; i <= opt.auctions + 1; i++) queue.push_back(uint64_t(i));
+
+    for (int slot = 0; slot < opt.auctions; slot++) {
+      uint64_t start_secs = init_secs + uint64_t(slot) * p.auctperiod;
+      run_slot(init_secs, start_secs);
+    }
+
+    // the last auction is settled by its winner
+    settle_by_claim(1e18);
+  }
+
+private:
+  void settle_by_claim(double now) {
+    if (settled || claim_time > now) return;
+    settle_sealed();
+    current.db_ops += DB_OPS_CLAIM;
+    finish(claim_time);
+    queue.pop_front();
+  }
+
+  void finish(double settle_time) {
+    current.price = highest;
+    current.settlement_delay = settle_time - double(latest.bidding_end_us) / 1e6;
+    revenue += double(highest);
+    results.push_back(current);
+    settled = true;
+  }
+
+  // the highest sealed bid that beats the open bidding by the bidstep wins; between equal bids the earliest
+  void settle_sealed() {
+    if (sealed.empty()) return;
+    current.db_ops += DB_OPS_SETTLE_SEALED + DB_OPS_SETTLE_SEALED_PER_ROW * int(sealed.size() - 1);
+
+    auto winner = sealed.begin();
+    for (auto it = sealed.begin(); it != sealed.end(); it++) {
+      bool earlier = it->second.amount == winner->second.amount && it->second.time < winner->second.time;
+      if (it->second.amount > winner->second.amount || earlier) winner = it;
+    }
+    if (winner->second.amount >= cronacle_rules::minimum_next_bid(highest, p.minimumbid, p.bidstep)) {
+      highest = winner->second.amount;
+      leader = winner->first;
+    }
+    sealed.clear();
+  }
+
+  bool in_batchwindow(double time) const {
+    return p.batchwindow > 0 && int64_t(time * 1e6) > latest.bidding_end_us - int64_t(p.batchwindow) * 1000000;
+  }
+
+  // a bid in the batchwindow replaces the bidder's sealed bid or, when the auction has its full number of sealed
+  // bids, the lowest one, which it must beat
+  bool seal(size_t bidder, int64_t amount, double time) {
+    bool replaces = sealed.count(bidder) > 0;
+    int held = int(sealed.size());
+    if (!replaces && sealed.size() == MAX_SEALED_BIDS) {
+      auto lowest = std::min_element(sealed.begin(), sealed.end(),
+        [](const auto &a, const auto &b) { return a.second.amount < b.second.amount; });
+      if (amount <= lowest->second.amount) return false;
+      sealed.erase(lowest);
+    }
+
+    sealed[bidder] = {amount, time};
+    current.sealed++;
+    current.db_ops += DB_OPS_SEALED_BID + (replaces ? 0 : DB_OPS_SEALED_BID_PER_ROW * held);
+    return true;
+  }
+
+  // a pre-bid replaces the bidder's pre-bid or, when the nft has its full number of pre-bids, the lowest one,
+  // which it must beat
+  void file_prebid(size_t bidder, int64_t amount, double time) {
+    if (amount < p.minimumbid) return;
+
+    bool replaces = prebids.count(bidder) > 0;
+    int held = int(prebids.size());
+    if (!replaces && prebids.size() == MAX_PREBIDS) {
+      auto lowest = std::min_element(prebids.begin(), prebids.end(),
+        [](const auto &a, const auto &b) { return a.second.amount < b.second.amount; });
+      if (amount <= lowest->second.amount) {
+        pending_rejected++;
+        return;
+      }
+      prebids.erase(lowest);
+    }
+
+    prebids[bidder] = {amount, time};
+    pending_prebids++;
+    pending_prebid_ops += DB_OPS_PREBID + (replaces ? 0 : DB_OPS_PREBID_PER_ROW * held);
+  }
+
+  // the nft that bidders go for: the first nft, or the second one once the first nft's auction period is over
+  // and the auction awaits settlement
+  uint64_t target_nft(double now) const {
+    if (queue.empty()) return 0;
+    if (settled || int64_t(now * 1e6) <= latest.end_us) return queue[0];
+    return queue.size() > 1 ? queue[1] : 0;
+  }
+
+  void run_slot(uint64_t init_secs, uint64_t start_secs) {
+    // the nft's common value and the bidders who want it
+    std::lognormal_distribution<double> common(std::log(opt.value) - 0.125, 0.5);
+    double nft_value = common(rng);
+
+    std::vector<bid_attempt> events;
+    std::vector<double> values(bidders.size(), 0);
+    std::bernoulli_distribution wants(opt.interest);
+    for (size_t i = 0; i < bidders.size(); i++) {
+      if (!wants(rng)) continue;
+      values[i] = nft_value * bidders[i].taste;
+      events.push_back({double(start_secs) + bidders[i].model->first_look(rng, p.bidperiod), i});
+    }
+
+    // bidders who want the nft may pre-bid on it before its auction opens
+    uint64_t slot_nft = target_nft(double(start_secs));
+    if (opt.prebid > 0 && slot_nft != 0 && !(latest.exists && latest.nftid == slot_nft)) {
+      std::bernoulli_distribution prebids_on(opt.prebid);
+      std::uniform_real_distribution<double> part(0.5, 0.8);
+      for (size_t i = 0; i < bidders.size(); i++) {
+        if (values[i] > 0 && prebids_on(rng)) file_prebid(i, int64_t(values[i] * part(rng)), double(start_secs));
+      }
+    }
+
+    // bids already placed in this slot, to give bidders a view that lags by the latency
+    std::vector<std::pair<double, int64_t>> history;
+    bool opened = false;
+
+    auto by_time = [](const bid_attempt &a, const bid_attempt &b) { return a.time > b.time; };
+    std::make_heap(events.begin(), events.end(), by_time);
+
+    while (!events.empty()) {
+      std::pop_heap(events.begin(), events.end(), by_time);
+      bid_attempt e = events.back();
+      events.pop_back();
+
+      settle_by_claim(e.time);
+      uint64_t nft_id = target_nft(e.time);
+      if (nft_id == 0) break;
+
+      // the bidder's view of the auction. Before it opens, the pre-bids that will become its opening bids are in view
+      int64_t seen_highest = 0;
+      if (!opened) {
+        for (const auto &prebid : prebids) seen_highest = std::max(seen_highest, prebid.second.amount);
+      }
+      for (const auto &h : history) {
+        if (h.first <= e.time - opt.latency) seen_highest = h.second;
+      }
+      bool leading = (opened && leader == e.bidder && highest > 0) || (nft_id == latest.nftid && sealed.count(e.bidder) > 0);
+      auction_view view = {e.time - double(start_secs), double(p.bidperiod), seen_highest,
+        cronacle_rules::minimum_next_bid(seen_highest, p.minimumbid, p.bidstep), leading};
+
+      const bidder_model *model = bidders[e.bidder].model;
+      int64_t amount = model->bid_amount(rng, view, values[e.bidder]);
+
+      if (amount > 0) {
+        submit(init_secs, e.time, e.bidder, nft_id, amount, opened, history);
+      }
+
+      double next = model->next_look(rng, view);
+      if (next >= 0 && e.time + next <= double(start_secs + p.bidperiod)) {
+        events.push_back({e.time + next, e.bidder});
+        std::push_heap(events.begin(), events.end(), by_time);
+      }
+    }
+
+    if (!opened) empty_slots++;
+  }
+
+  void submit(uint64_t init_secs, double time, size_t bidder, uint64_t nft_id, int64_t amount, bool &opened,
+              std::vector<std::pair<double, int64_t>> &history) {
+    int64_t now_us = int64_t(time * 1e6);
+    uint64_t first_nft = queue.empty() ? 0 : queue[0];
+    uint64_t second_nft = queue.size() > 1 ? queue[1] : 0;
+
+    switch (cronacle_rules::route_bid(nft_id, first_nft, second_nft, latest, now_us)) {
+      case cronacle_rules::bid_route::not_offered:
+      case cronacle_rules::bid_route::bidding_ended:
+      case cronacle_rules::bid_route::close_and_reopen:   // modelled auctions always have a bid, so never reopen
+        pending_rejected++;
+        return;
+
+      case cronacle_rules::bid_route::add_bid:
+        if (amount < cronacle_rules::minimum_next_bid(highest, p.minimumbid, p.bidstep)) {
+          current.rejected++;
+          return;
+        }
+        if (in_batchwindow(time)) {
+          if (seal(bidder, amount, time)) current.accepted++;
+          else current.rejected++;
+          return;
+        }
+        current.accepted++;
+        current.db_ops += DB_OPS_BID;
+        break;
+
+      case cronacle_rules::bid_route::open_first:
+      case cronacle_rules::bid_route::close_and_open: {
+        bool closes = !settled;
+
+        // the highest pre-bids become the opening bids, which the bid must beat
+        std::vector<std::pair<size_t, held_bid>> opening(prebids.begin(), prebids.end());
+        std::sort(opening.begin(), opening.end(), [](const auto &a, const auto &b) { return a.second.amount > b.second.amount; });
+        if (opening.size() > APPLIED_PREBIDS) opening.resize(APPLIED_PREBIDS);
+        int64_t opening_highest = opening.empty() ? 0 : opening[0].second.amount;
+
+        if (amount < cronacle_rules::minimum_next_bid(opening_highest, p.minimumbid, p.bidstep)) {
+          pending_rejected++;
+          return;
+        }
+        cronacle_rules::auction_window window = cronacle_rules::window_at(init_secs, uint64_t(time), p.auctperiod, p.bidperiod);
+        if (!window.bidding_open) {
+          pending_rejected++;
+          return;
+        }
+
+        if (closes) {
+          // the previous auction is settled by this bid
+          settle_sealed();
+          current.db_ops += DB_OPS_CLOSE_AND_OPEN - DB_OPS_OPEN_BID;
+          finish(time);
+          queue.pop_front();
+        }
+
+        latest = {true, nft_id, int64_t(window.start_secs) * 1000000, int64_t(window.bidding_end_secs) * 1000000,
+          int64_t(window.end_ms) * 1000};
+        settled = false;
+        highest = 0;
+        current = auction_result();
+        current.accepted = 1;
+        current.rejected = pending_rejected;
+        current.prebids = pending_prebids;
+        current.db_ops = DB_OPS_OPEN_BID + pending_prebid_ops + DB_OPS_APPLY_PREBID * int(opening.size()) +
+          DB_OPS_CLEAR_PREBID * int(prebids.size() - opening.size());
+        pending_rejected = 0;
+        pending_prebids = 0;
+        pending_prebid_ops = 0;
+        prebids.clear();
+        claim_time = double(window.bidding_end_secs) + std::exponential_distribution<double>(1.0 / opt.claimdelay)(rng);
+        opened = true;
+
+        if (!opening.empty()) {
+          highest = opening_highest;
+          leader = opening[0].first;
+          history.push_back({double(window.start_secs), opening_highest});
+        }
+        if (in_batchwindow(time)) {
+          seal(bidder, amount, time);
+          return;
+        }
+        break;
+      }
+    }
+
+    highest = amount;
+    leader = bidder;
+    history.push_back({time, amount});
+  }
+};
+
+
+// a work item: a run of seasons of one parameter set
+struct task {
+  size_t set;
+  int    first_season;
+  int    seasons;
+};
+
+// per-worker task deques. A worker takes from the back of its own deque and steals from the front of the others
+class work_pool {
+  struct worker_queue {
+    std::mutex lock;
+    std::deque<task> tasks;
+  };
+
+  std::vector<std::unique_ptr<worker_queue>> queues;
+
+public:
+  explicit work_pool(unsigned workers) {
+    for (unsigned i = 0; i < workers; i++) queues.emplace_back(new worker_queue());
+  }
+
+  void push(unsigned worker, const task &t) {
+    std::lock_guard<std::mutex> guard(queues[worker]->lock);
+    queues[worker]->tasks.push_back(t);
+  }
+
+  bool take(unsigned worker, task &t) {
+    {
+      std::lock_guard<std::mutex> guard(queues[worker]->lock);
+      if (!queues[worker]->tasks.empty()) {
+        t = queues[worker]->tasks.back();
+        queues[worker]->tasks.pop_back();
+        return true;
+      }
+    }
+
+    // no work of our own: steal from the other workers, starting with the next one
+    for (size_t i = 1; i < queues.size(); i++) {
+      worker_queue &victim = *queues[(worker + i) % queues.size()];
+      std::lock_guard<std::mutex> guard(victim.lock);
+      if (!victim.tasks.empty()) {
+        t = victim.tasks.front();
+        victim.tasks.pop_front();
+        return true;
+      }
+    }
+
+    return false;
+  }
+};
+
+
+uint64_t mix_seed(uint64_t seed, uint64_t set, uint64_t season) {
+  uint64_t x = seed * 0x9e3779b97f4a7c15ULL ^ (set + 1) * 0xbf58476d1ce4e5b9ULL ^ (season + 1) * 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  x *= 0xd6e8feb86659fd93ULL;
+  return x ^ (x >> 32);
+}
+
+
+void run_task(const options &opt, const std::vector<const bidder_model *> &models, const task &t, set_results &out) {
+  std::vector<auction_result> auctions;
+  std::vector<double> revenue;
+  uint64_t empty_slots = 0;
+
+  for (int s = t.first_season; s < t.first_season + t.seasons; s++) {
+    season sim(opt, opt.sets[t.set], models, mix_seed(opt.seed, t.set, uint64_t(s)), auctions);
+    sim.run();
+    revenue.push_back(sim.revenue);
+    empty_slots += sim.empty_slots;
+  }
+
+  std::lock_guard<std::mutex> guard(out.lock);
+  out.auctions.insert(out.auctions.end(), auctions.begin(), auctions.end());
+  out.revenue.insert(out.revenue.end(), revenue.begin(), revenue.end());
+  out.slots += uint64_t(t.seasons) * uint64_t(opt.auctions);
+  out.empty_slots += empty_slots;
+}
+
+
+void print_distribution(const char *label, std::vector<double> values) {
+  if (values.empty()) {
+    std::printf("  %-22s no data\n", label);
+    return;
+  }
+
+  std::sort(values.begin(), values.end());
+  double sum = 0;
+  for (double v : values) sum += v;
+  auto at = [&](double q) { return values[size_t(q * double(values.size() - 1))]; };
+
+  std::printf("  %-22s mean %10.2f  p10 %10.2f  p50 %10.2f  p90 %10.2f\n", label, sum / double(values.size()), at(0.1), at(0.5), at(0.9));
+}
+
+
+void print_results(const parameter_set &p, set_results &r) {
+  std::printf("auctperiod %u bidperiod %u minimumbid %lld bidstep %lld batchwindow %u: %zu auctions\n", p.auctperiod,
+    p.bidperiod, (long long)p.minimumbid, (long long)p.bidstep, p.batchwindow, r.auctions.size());
+
+  std::vector<double> accepted, sealed, prebids, rejected, db_ops, price, delay;
+  for (const auto &a : r.auctions) {
+    accepted.push_back(a.accepted);
+    sealed.push_back(a.sealed);
+    prebids.push_back(a.prebids);
+    rejected.push_back(a.rejected);
+    db_ops.push_back(a.db_ops);
+    price.push_back(double(a.price));
+    delay.push_back(a.settlement_delay);
+  }
+
+  print_distribution("bid transactions", accepted);
+  print_distribution("sealed bids", sealed);
+  print_distribution("pre-bid transactions", prebids);
+  print_distribution("rejected bids", rejected);
+  print_distribution("database operations", db_ops);
+  print_distribution("clearing price", price);
+  print_distribution("settlement delay (s)", delay);
+  print_distribution("revenue per season", r.revenue);
+  std::printf("  %-22s %.1f%%\n\n", "empty slots", r.slots ? 100.0 * double(r.empty_slots) / double(r.slots) : 0.0);
+}
+
+
+template<typename T>
+std::vector<T> parse_list(const std::string &text) {
+  std::vector<T> values;
+  std::stringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ',')) values.push_back(T(std::stoll(item)));
+  if (values.empty()) throw std::runtime_error("empty list");
+  return values;
+}
+
+
+int usage() {
+  std::cerr << "usage: cronacle_simulator [--auctperiod LIST] [--bidperiod LIST] [--minimumbid LIST] [--bidstep LIST]\n"
+               "       [--batchwindow LIST] [--seasons N] [--auctions N] [--bidders N] [--interest P] [--value V]\n"
+               "       [--models name:weight,...] [--latency S] [--claimdelay S] [--prebid P] [--threads N] [--seed N]\n";
+  return 2;
+}
+
+
+int main(int argc, char **argv) {
+  options opt;
+  std::vector<uint32_t> auctperiods = {3600}, bidperiods = {1800};
+  std::vector<int64_t> minimumbids = {1}, bidsteps = {1};
+  std::vector<uint32_t> batchwindows = {0};
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      if (i + 1 >= argc) return usage();
+      std::string value = argv[++i];
+
+      if (arg == "--auctperiod") auctperiods = parse_list<uint32_t>(value);
+      else if (arg == "--bidperiod") bidperiods = parse_list<uint32_t>(value);
+      else if (arg == "--minimumbid") minimumbids = parse_list<int64_t>(value);
+      else if (arg == "--bidstep") bidsteps = parse_list<int64_t>(value);
+      else if (arg == "--batchwindow") batchwindows = parse_list<uint32_t>(value);
+      else if (arg == "--seasons") opt.seasons = std::stoi(value);
+      else if (arg == "--auctions") opt.auctions = std::stoi(value);
+      else if (arg == "--bidders") opt.bidders = std::stoi(value);
+      else if (arg == "--interest") opt.interest = std::stod(value);
+      else if (arg == "--value") opt.value = std::stod(value);
+      else if (arg == "--latency") opt.latency = std::stod(value);
+      else if (arg == "--claimdelay") opt.claimdelay = std::stod(value);
+      else if (arg == "--prebid") opt.prebid = std::stod(value);
+      else if (arg == "--threads") opt.threads = unsigned(std::stoul(value));
+      else if (arg == "--seed") opt.seed = std::stoull(value);
+      else if (arg == "--models") {
+        opt.models.clear();
+        std::stringstream stream(value);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+          size_t colon = item.find(':');
+          std::string model = item.substr(0, colon);
+          double weight = (colon == std::string::npos) ? 1.0 : std::stod(item.substr(colon + 1));
+          if (model_registry().find(model) == model_registry().end()) throw std::runtime_error("unknown model " + model);
+          opt.models.push_back({model, weight});
+        }
+      }
+      else return usage();
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "invalid option: " << e.what() << "\n";
+    return usage();
+  }
+
+  for (uint32_t a : auctperiods)
+    for (uint32_t b : bidperiods)
+      for (int64_t m : minimumbids)
+        for (int64_t s : bidsteps) {
+          if (b == 0 || b >= a) {
+            std::cerr << "skipping bidperiod " << b << " with auctperiod " << a << ": bidding must end within the auction\n";
+            continue;
+          }
+          for (uint32_t w : batchwindows) opt.sets.push_back({a, b, m, s, w});
+        }
+
+  if (opt.sets.empty() || opt.models.empty() || opt.seasons <= 0 || opt.auctions <= 0) return usage();
+
+  std::vector<std::unique_ptr<bidder_model>> model_objects;
+  std::vector<const bidder_model *> models;
+  for (const auto &m : opt.models) {
+    model_objects.push_back(model_registry()[m.first]());
+    models.push_back(model_objects.back().get());
+  }
+
+  unsigned workers = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+  work_pool pool(workers);
+
+  // deal the work out round robin; stealing evens out the sets that take longer
+  unsigned next_worker = 0;
+  for (size_t set = 0; set < opt.sets.size(); set++) {
+    for (int s = 0; s < opt.seasons; s += SEASONS_PER_TASK) {
+      pool.push(next_worker, {set, s, std::min(SEASONS_PER_TASK, opt.seasons - s)});
+      next_worker = (next_worker + 1) % workers;
+    }
+  }
+
+  std::vector<std::unique_ptr<set_results>> results;
+  for (size_t set = 0; set < opt.sets.size(); set++) results.emplace_back(new set_results());
+
+  std::vector<std::thread> threads;
+  for (unsigned w = 0; w < workers; w++) {
+    threads.emplace_back([&, w] {
+      task t;
+      while (pool.take(w, t)) run_task(opt, models, t, *results[t.set]);
+    });
+  }
+  for (auto &thread : threads) thread.join();
+
+  for (size_t set = 0; set < opt.sets.size(); set++) print_results(opt.sets[set], *results[set]);
+
+  return 0;
+}
@@ -0,0 +1,266 @@
+// cronacle_snapshot packs a text dump of the cronacle tables into importstate chunks.
+//
+// Build:  g++ -std=c++17 -O2 -o cronacle_snapshot tools/cronacle_snapshot.cpp
+// Usage:  cronacle_snapshot [-n rows_per_chunk] < dump.txt > chunks.txt
+//
+// The dump has one row per line, the table name first, and is written by hand or by tools/cronacle_export. Times
+// are microseconds since the epoch and amounts are written with the currency's precision, e.g. 12.3456 FREEOS;
+// an asset with no symbol, such as the amount of an unsold auction, is written as its integer amount and -.
+// Blank lines and lines starting with # are skipped.
+//
+//   users       <account> <time> [principal]
+//   credits     <account> <amount> <code>
+//   auctions    <scope> <number> <nftid> <start> <bidding_end> <end> <winner or -> <amount> <code>
+//   auctionhead <number> <scope>
+//   nfts        <number> <nftid> [bundled nftid ...]
+//   parameters  <paramname> <value, the rest of the line>
+//   admins      <account>
+//   system      <init> <usercount> <cls amount> <code>
+//   subaccounts <custodian> <id> <amount> <code>
+//   custodians  <account> <held amount> <code> <bid_subaccount> <bid_nftid> <bid amount> <code>
+//
+// An auctions or auctionhead scope is a season number, or - for the contract's scope.
+//
+// Each output line is "<table> <hex chunk>", at most rows_per_chunk rows of one table, ready to load with
+//
+//   while read table chunk; do
+//     cleos push action cronacle importstate "[\"$table\",\"$chunk\"]" -p cronacle
+//   done < chunks.txt
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// must match MAX_IMPORT_ROWS in cronacle.hpp
+const size_t MAX_IMPORT_ROWS = 100;
+
+typedef std::vector<uint8_t> bytes;
+
+
+// eosio name encoding
+uint64_t name_value(const std::string &text) {
+  if (text.size() > 13) throw std::runtime_error("name is too long: " + text);
+
+  auto char_value = [&](char c) -> uint64_t {
+    if (c >= 'a' && c <= 'z') return (c - 'a') + 6;
+    if (c >= '1' && c <= '5') return (c - '1') + 1;
+    if (c == '.') return 0;
+    throw std::runtime_error("invalid character in name: " + text);
+  };
+
+  uint64_t value = 0;
+  for (size_t i = 0; i < 13; i++) {
+    uint64_t c = (i < text.size()) ? char_value(text[i]) : 0;
+    if (i < 12) {
+      value |= (c & 0x1f) << (64 - 5 * (i + 1));
+    } else {
+      if (c > 0x0f) throw std::runtime_error("invalid 13th character in name: " + text);
+      value |= c & 0x0f;
+    }
+  }
+
+  return value;
+}
+
+
+void put_u8(bytes &out, uint8_t v) { out.push_back(v); }
+
+void put_u32(bytes &out, uint32_t v) {
+  for (int i = 0; i < 4; i++) out.push_back(uint8_t(v >> (8 * i)));
+}
+
+void put_u64(bytes &out, uint64_t v) {
+  for (int i = 0; i < 8; i++) out.push_back(uint8_t(v >> (8 * i)));
+}
+
+void put_varuint32(bytes &out, uint32_t v) {
+  do {
+    uint8_t b = v & 0x7f;
+    v >>= 7;
+    out.push_back(b | (v ? 0x80 : 0));
+  } while (v);
+}
+
+void put_string(bytes &out, const std::string &s) {
+  put_varuint32(out, uint32_t(s.size()));
+  out.insert(out.end(), s.begin(), s.end());
+}
+
+void put_name(bytes &out, const std::string &text) { put_u64(out, name_value(text)); }
+
+void put_time(bytes &out, const std::string &micros) { put_u64(out, uint64_t(std::stoll(micros))); }
+
+// an auctions table scope: a season number, or - for the contract's scope, which importstate writes for 0
+void put_scope(bytes &out, const std::string &scope) { put_u64(out, scope == "-" ? 0 : std::stoull(scope)); }
+
+// asset: int64 amount in the smallest unit, then the symbol (precision in the low byte, code above it). The code
+// - stands for no symbol
+void put_asset(bytes &out, const std::string &amount, const std::string &code) {
+  if (code == "-") {
+    put_u64(out, uint64_t(std::stoll(amount)));
+    put_u64(out, 0);
+    return;
+  }
+  if (code.empty() || code.size() > 7) throw std::runtime_error("invalid currency code: " + code);
+
+  size_t point = amount.find('.');
+  std::string digits = amount;
+  uint8_t precision = 0;
+  if (point != std::string::npos) {
+    precision = uint8_t(amount.size() - point - 1);
+    digits.erase(point, 1);
+  }
+
+  uint64_t symbol = precision;
+  for (size_t i = 0; i < code.size(); i++) {
+    symbol |= uint64_t(uint8_t(code[i])) << (8 * (i + 1));
+  }
+
+  put_u64(out, uint64_t(std::stoll(digits)));
+  put_u64(out, symbol);
+}
+
+
+// packs one dump line into the row format of its table
+bytes pack_row(const std::string &table, std::istringstream &fields) {
+  bytes row;
+  std::string a, b, c, d, e, f, g, h, i;
+
+  if (table == "users") {
+    fields >> a >> b;
+    fields >> c;  // the principal is optional
+    put_name(row, a);
+    put_time(row, b);
+    put_string(row, c);
+  } else if (table == "credits") {
+    fields >> a >> b >> c;
+    put_name(row, a);
+    put_asset(row, b, c);
+  } else if (table == "auctions") {
+    fields >> i >> a >> b >> c >> d >> e >> f >> g >> h;
+    put_scope(row, i);
+    put_u32(row, uint32_t(std::stoul(a)));
+    put_u64(row, std::stoull(b));
+    put_time(row, c);
+    put_time(row, d);
+    put_time(row, e);
+    put_name(row, f == "-" ? "" : f);
+    put_asset(row, g, h);
+  } else if (table == "auctionhead") {
+    fields >> a >> b;
+    put_u32(row, uint32_t(std::stoul(a)));
+    put_scope(row, b);
+  } else if (table == "nfts") {
+    fields >> a >> b;
+    std::vector<uint64_t> bundle;
+    while (fields >> c) bundle.push_back(std::stoull(c));
+    put_u32(row, uint32_t(std::stoul(a)));
+    put_u64(row, std::stoull(b));
+    put_varuint32(row, uint32_t(bundle.size()));
+    for (uint64_t id : bundle) put_u64(row, id);
+  } else if (table == "parameters") {
+    fields >> a >> std::ws;
+    std::getline(fields, b);
+    put_name(row, a);
+    put_string(row, b);
+  } else if (table == "admins") {
+    fields >> a;
+    put_name(row, a);
+  } else if (table == "system") {
+    fields >> a >> b >> c >> d;
+    put_time(row, a);
+    put_u32(row, uint32_t(std::stoul(b)));
+    put_asset(row, c, d);
+  } else if (table == "subaccounts") {
+    fields >> a >> b >> c >> d;
+    put_name(row, a);
+    put_u64(row, std::stoull(b));
+    put_asset(row, c, d);
+  } else if (table == "custodians") {
+    fields >> a >> b >> c >> d >> e >> f >> g;
+    put_name(row, a);
+    put_asset(row, b, c);
+    put_u64(row, std::stoull(d));
+    put_u64(row, std::stoull(e));
+    put_asset(row, f, g);
+  } else {
+    throw std::runtime_error("unknown table: " + table);
+  }
+
+  return row;
+}
+
+
+// writes one chunk: a packed vector of rows, as hex
+void write_chunk(const std::string &table, const std::vector<bytes> &rows) {
+  bytes chunk;
+  put_varuint32(chunk, uint32_t(rows.size()));
+  for (const auto &row : rows) chunk.insert(chunk.end(), row.begin(), row.end());
+
+  static const char *hex = "0123456789abcdef";
+  std::string text;
+  text.reserve(chunk.size() * 2);
+  for (uint8_t byte : chunk) {
+    text += hex[byte >> 4];
+    text += hex[byte & 0x0f];
+  }
+
+  std::cout << table << " " << text << "\n";
+}
+
+
+int main(int argc, char **argv) {
+  size_t rows_per_chunk = MAX_IMPORT_ROWS;
+
+  if (argc == 3 && std::string(argv[1]) == "-n") {
+    rows_per_chunk = std::strtoul(argv[2], nullptr, 10);
+  } else if (argc != 1) {
+    std::cerr << "usage: cronacle_snapshot [-n rows_per_chunk] < dump.txt > chunks.txt\n";
+    return 2;
+  }
+
+  if (rows_per_chunk == 0 || rows_per_chunk > MAX_IMPORT_ROWS) {
+    std::cerr << "rows_per_chunk must be between 1 and " << MAX_IMPORT_ROWS << "\n";
+    return 2;
+  }
+
+  // rows are grouped by table, in the order the tables first appear
+  std::vector<std::string> table_order;
+  std::map<std::string, std::vector<bytes>> pending;
+
+  std::string line;
+  size_t line_number = 0;
+
+  try {
+    while (std::getline(std::cin, line)) {
+      line_number++;
+      std::istringstream fields(line);
+      std::string table;
+      if (!(fields >> table) || table[0] == '#') continue;
+
+      if (pending.find(table) == pending.end()) table_order.push_back(table);
+      std::vector<bytes> &rows = pending[table];
+      rows.push_back(pack_row(table, fields));
+
+      if (rows.size() == rows_per_chunk) {
+        write_chunk(table, rows);
+        rows.clear();
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "line " << line_number << ": " << e.what() << "\n";
+    return 1;
+  }
+
+  for (const auto &table : table_order) {
+    if (!pending[table].empty()) write_chunk(table, pending[table]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// part of the native host: see eosio.hpp
+#include <eosio/eosio.hpp>
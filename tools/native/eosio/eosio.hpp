@@ -0,0 +1,997 @@
+#pragma once
+
+// Native host for building the contract into the native tools, in place of the CDT headers.
+//
+// A tool puts tools/native first on its include path and includes ../cronacle.cpp, so that the contract's
+// #include <eosio/...> lines find these headers. The tool then calls the contract's actions as member functions
+// of a cronacle object. This header covers the part of the CDT that the contract uses: names, symbols, assets,
+// time, the ABI serialization, sha256, actions and authorization. multi_index.hpp adds the tables.
+//
+// native::host() holds the chain state: the clock, the authorizations of the current action, the console, the
+// inline actions sent, the tables and the RAM billed to each payer. Between begin_action() and commit() every
+// table write is recorded, so that revert() can undo the action when a check fails, as the chain does.
+// The host also counts the database intrinsics the CDT would call (db_find_i64, db_next_i64, db_store_i64,
+// db_idx64_lowerbound and so on) and bills RAM with the chain's billable row sizes.
+//
+// The ABI serialization works on any aggregate with up to 8 fields, which covers the contract's table rows and
+// action arguments. Attributes such as [[eosio::action]] are ignored by g++, which needs -Wno-attributes.
+
+#include <algorithm>
+#include <any>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace eosio {
+
+// a failed check, which aborts the action
+struct check_failure : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+inline void check(bool condition, const char *message) {
+  if (!condition) throw check_failure(message);
+}
+
+inline void check(bool condition, const std::string &message) {
+  if (!condition) throw check_failure(message);
+}
+
+
+// NAME
+
+struct name {
+  enum class raw : uint64_t {};
+
+  uint64_t value = 0;
+
+  constexpr name() = default;
+  constexpr explicit name(uint64_t v) : value(v) {}
+  constexpr name(raw r) : value(static_cast<uint64_t>(r)) {}
+
+  constexpr explicit name(std::string_view str) {
+    if (str.size() > 13) throw check_failure("string is too long to be a valid name");
+    if (str.empty()) return;
+
+    auto n = std::min<size_t>(str.size(), 12);
+    for (size_t i = 0; i < n; i++) {
+      value <<= 5;
+      value |= char_to_value(str[i]);
+    }
+    value <<= (4 + 5 * (12 - n));
+    if (str.size() == 13) {
+      uint64_t v = char_to_value(str[12]);
+      if (v > 0x0f) throw check_failure("thirteenth character in name cannot be a letter that comes after j");
+      value |= v;
+    }
+  }
+
+  static constexpr uint8_t char_to_value(char c) {
+    if (c == '.') return 0;
+    if (c >= '1' && c <= '5') return uint8_t(c - '1') + 1;
+    if (c >= 'a' && c <= 'z') return uint8_t(c - 'a') + 6;
+    throw check_failure("character is not in allowed character set for names");
+  }
+
+  std::string to_string() const {
+    static const char *charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+    std::string str(13, '.');
+    uint64_t tmp = value;
+    for (uint32_t i = 0; i <= 12; i++) {
+      char c = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+      str[12 - i] = c;
+      tmp >>= (i == 0 ? 4 : 5);
+    }
+    while (!str.empty() && str.back() == '.') str.pop_back();
+    return str;
+  }
+
+  void print() const;
+
+  constexpr operator raw() const { return raw(value); }
+  constexpr explicit operator bool() const { return value != 0; }
+
+  friend constexpr bool operator==(const name &a, const name &b) { return a.value == b.value; }
+  friend constexpr bool operator!=(const name &a, const name &b) { return a.value != b.value; }
+  friend constexpr bool operator<(const name &a, const name &b) { return a.value < b.value; }
+};
+
+} // namespace eosio
+
+template<typename T, T... Str>
+inline constexpr eosio::name operator""_n() {
+  constexpr char str[] = {Str...};
+  return eosio::name(std::string_view(str, sizeof...(Str)));
+}
+
+namespace eosio {
+
+// SYMBOLS AND ASSETS
+
+class symbol_code {
+  uint64_t value = 0;
+
+public:
+  constexpr symbol_code() = default;
+  constexpr explicit symbol_code(uint64_t raw) : value(raw) {}
+
+  constexpr explicit symbol_code(std::string_view str) {
+    if (str.size() > 7) throw check_failure("string is too long to be a valid symbol_code");
+    for (auto itr = str.rbegin(); itr != str.rend(); ++itr) {
+      if (*itr < 'A' || *itr > 'Z') throw check_failure("only uppercase letters allowed in symbol_code string");
+      value <<= 8;
+      value |= uint64_t(*itr);
+    }
+  }
+
+  constexpr uint64_t raw() const { return value; }
+  constexpr explicit operator bool() const { return value != 0; }
+
+  std::string to_string() const {
+    std::string s;
+    for (uint64_t v = value; v != 0; v >>= 8) s += char(v & 0xff);
+    return s;
+  }
+
+  friend constexpr bool operator==(const symbol_code &a, const symbol_code &b) { return a.value == b.value; }
+  friend constexpr bool operator!=(const symbol_code &a, const symbol_code &b) { return a.value != b.value; }
+  friend constexpr bool operator<(const symbol_code &a, const symbol_code &b) { return a.value < b.value; }
+};
+
+class symbol {
+  uint64_t value = 0;
+
+public:
+  constexpr symbol() = default;
+  constexpr explicit symbol(uint64_t raw) : value(raw) {}
+  constexpr symbol(symbol_code sc, uint8_t precision) : value(sc.raw() << 8 | precision) {}
+  constexpr symbol(std::string_view code, uint8_t precision) : value(symbol_code(code).raw() << 8 | precision) {}
+
+  constexpr uint64_t raw() const { return value; }
+  constexpr uint8_t precision() const { return uint8_t(value & 0xff); }
+  constexpr symbol_code code() const { return symbol_code(value >> 8); }
+  constexpr bool is_valid() const { return code().raw() != 0; }
+  constexpr explicit operator bool() const { return value != 0; }
+
+  friend constexpr bool operator==(const symbol &a, const symbol &b) { return a.value == b.value; }
+  friend constexpr bool operator!=(const symbol &a, const symbol &b) { return a.value != b.value; }
+  friend constexpr bool operator<(const symbol &a, const symbol &b) { return a.value < b.value; }
+};
+
+class extended_symbol {
+  symbol sym;
+  name contract;
+
+public:
+  constexpr extended_symbol() = default;
+  constexpr extended_symbol(symbol s, name c) : sym(s), contract(c) {}
+
+  constexpr symbol get_symbol() const { return sym; }
+  constexpr name get_contract() const { return contract; }
+
+  friend constexpr bool operator==(const extended_symbol &a, const extended_symbol &b) {
+    return a.sym == b.sym && a.contract == b.contract;
+  }
+  friend constexpr bool operator!=(const extended_symbol &a, const extended_symbol &b) { return !(a == b); }
+};
+
+struct asset {
+  static constexpr int64_t max_amount = (1LL << 62) - 1;
+
+  int64_t amount = 0;
+  eosio::symbol symbol;
+
+  asset() = default;
+  asset(int64_t a, eosio::symbol s) : amount(a), symbol(s) {
+    check(is_amount_within_range(), "magnitude of asset amount must be less than 2^62");
+    check(symbol.is_valid(), "invalid symbol name");
+  }
+
+  bool is_amount_within_range() const { return -max_amount <= amount && amount <= max_amount; }
+  bool is_valid() const { return is_amount_within_range() && symbol.is_valid(); }
+
+  asset operator-() const {
+    asset r = *this;
+    r.amount = -r.amount;
+    return r;
+  }
+
+  asset &operator-=(const asset &a) {
+    check(a.symbol == symbol, "attempt to subtract asset with different symbol");
+    amount -= a.amount;
+    check(-max_amount <= amount, "subtraction underflow");
+    check(amount <= max_amount, "subtraction overflow");
+    return *this;
+  }
+
+  asset &operator+=(const asset &a) {
+    check(a.symbol == symbol, "attempt to add asset with different symbol");
+    amount += a.amount;
+    check(-max_amount <= amount, "addition underflow");
+    check(amount <= max_amount, "addition overflow");
+    return *this;
+  }
+
+  asset &operator*=(int64_t a) {
+    __int128 tmp = (__int128)amount * (__int128)a;
+    check(tmp <= max_amount, "multiplication overflow");
+    check(tmp >= -max_amount, "multiplication underflow");
+    amount = int64_t(tmp);
+    return *this;
+  }
+
+  asset &operator/=(int64_t a) {
+    check(a != 0, "divide by zero");
+    check(!(amount == std::numeric_limits<int64_t>::min() && a == -1), "signed division overflow");
+    amount /= a;
+    return *this;
+  }
+
+  friend asset operator+(const asset &a, const asset &b) { asset r = a; r += b; return r; }
+  friend asset operator-(const asset &a, const asset &b) { asset r = a; r -= b; return r; }
+  friend asset operator*(const asset &a, int64_t b) { asset r = a; r *= b; return r; }
+  friend asset operator*(int64_t b, const asset &a) { asset r = a; r *= b; return r; }
+  friend asset operator/(const asset &a, int64_t b) { asset r = a; r /= b; return r; }
+
+  friend int64_t operator/(const asset &a, const asset &b) {
+    check(b.amount != 0, "divide by zero");
+    check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+    return a.amount / b.amount;
+  }
+
+  friend bool operator==(const asset &a, const asset &b) {
+    check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+    return a.amount == b.amount;
+  }
+  friend bool operator!=(const asset &a, const asset &b) { return !(a == b); }
+  friend bool operator<(const asset &a, const asset &b) {
+    check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+    return a.amount < b.amount;
+  }
+  friend bool operator<=(const asset &a, const asset &b) { return !(b < a); }
+  friend bool operator>(const asset &a, const asset &b) { return b < a; }
+  friend bool operator>=(const asset &a, const asset &b) { return !(a < b); }
+
+  std::string to_string() const {
+    bool negative = amount < 0;
+    uint64_t magnitude = negative ? uint64_t(-amount) : uint64_t(amount);
+    uint8_t precision = symbol.precision();
+
+    std::string digits = std::to_string(magnitude);
+    if (precision > 0) {
+      if (digits.size() <= precision) digits.insert(0, precision + 1 - digits.size(), '0');
+      digits.insert(digits.size() - precision, ".");
+    }
+    return (negative ? "-" : "") + digits + " " + symbol.code().to_string();
+  }
+
+  void print() const;
+};
+
+
+// TIME
+
+class microseconds {
+  int64_t _count = 0;
+
+public:
+  constexpr microseconds() = default;
+  constexpr explicit microseconds(int64_t c) : _count(c) {}
+
+  constexpr int64_t count() const { return _count; }
+  constexpr int64_t to_seconds() const { return _count / 1000000; }
+
+  constexpr microseconds &operator+=(const microseconds &m) { _count += m._count; return *this; }
+  constexpr microseconds &operator-=(const microseconds &m) { _count -= m._count; return *this; }
+
+  friend constexpr microseconds operator+(const microseconds &a, const microseconds &b) { return microseconds(a._count + b._count); }
+  friend constexpr microseconds operator-(const microseconds &a, const microseconds &b) { return microseconds(a._count - b._count); }
+  friend constexpr bool operator==(const microseconds &a, const microseconds &b) { return a._count == b._count; }
+  friend constexpr bool operator!=(const microseconds &a, const microseconds &b) { return a._count != b._count; }
+  friend constexpr bool operator<(const microseconds &a, const microseconds &b) { return a._count < b._count; }
+  friend constexpr bool operator<=(const microseconds &a, const microseconds &b) { return a._count <= b._count; }
+  friend constexpr bool operator>(const microseconds &a, const microseconds &b) { return a._count > b._count; }
+  friend constexpr bool operator>=(const microseconds &a, const microseconds &b) { return a._count >= b._count; }
+};
+
+inline constexpr microseconds milliseconds(int64_t ms) { return microseconds(ms * 1000); }
+inline constexpr microseconds seconds(int64_t s) { return milliseconds(s * 1000); }
+inline constexpr microseconds minutes(int64_t m) { return seconds(60 * m); }
+inline constexpr microseconds hours(int64_t h) { return minutes(60 * h); }
+inline constexpr microseconds days(int64_t d) { return hours(24 * d); }
+
+class time_point {
+  microseconds elapsed;
+
+public:
+  constexpr time_point() = default;
+  constexpr explicit time_point(microseconds e) : elapsed(e) {}
+
+  constexpr const microseconds &time_since_epoch() const { return elapsed; }
+  constexpr uint32_t sec_since_epoch() const { return uint32_t(elapsed.count() / 1000000); }
+
+  constexpr time_point &operator+=(const microseconds &m) { elapsed += m; return *this; }
+  constexpr time_point &operator-=(const microseconds &m) { elapsed -= m; return *this; }
+
+  friend constexpr time_point operator+(const time_point &t, const microseconds &m) { return time_point(t.elapsed + m); }
+  friend constexpr time_point operator-(const time_point &t, const microseconds &m) { return time_point(t.elapsed - m); }
+  friend constexpr microseconds operator-(const time_point &a, const time_point &b) { return a.elapsed - b.elapsed; }
+  friend constexpr bool operator==(const time_point &a, const time_point &b) { return a.elapsed == b.elapsed; }
+  friend constexpr bool operator!=(const time_point &a, const time_point &b) { return a.elapsed != b.elapsed; }
+  friend constexpr bool operator<(const time_point &a, const time_point &b) { return a.elapsed < b.elapsed; }
+  friend constexpr bool operator<=(const time_point &a, const time_point &b) { return a.elapsed <= b.elapsed; }
+  friend constexpr bool operator>(const time_point &a, const time_point &b) { return a.elapsed > b.elapsed; }
+  friend constexpr bool operator>=(const time_point &a, const time_point &b) { return a.elapsed >= b.elapsed; }
+};
+
+
+// BINARY EXTENSIONS
+
+template<typename T>
+class binary_extension {
+  std::optional<T> stored;
+
+public:
+  binary_extension() = default;
+  binary_extension(const T &v) : stored(v) {}
+  binary_extension(T &&v) : stored(std::move(v)) {}
+
+  constexpr bool has_value() const { return stored.has_value(); }
+  constexpr explicit operator bool() const { return stored.has_value(); }
+
+  const T &value() const {
+    check(stored.has_value(), "cannot get value of empty binary_extension");
+    return *stored;
+  }
+  T &value() {
+    check(stored.has_value(), "cannot get value of empty binary_extension");
+    return *stored;
+  }
+
+  T value_or() const { return stored.has_value() ? *stored : T(); }
+  template<typename U> T value_or(U &&def) const { return stored.has_value() ? *stored : T(std::forward<U>(def)); }
+
+  const T &operator*() const { return value(); }
+  T &operator*() { return value(); }
+  const T *operator->() const { return &value(); }
+  T *operator->() { return &value(); }
+
+  template<typename... Args> T &emplace(Args &&... args) { return stored.emplace(std::forward<Args>(args)...); }
+  void reset() { stored.reset(); }
+};
+
+
+// SERIALIZATION
+
+namespace native {
+
+// converts to any field type, to count the fields of an aggregate
+struct any_field {
+  template<typename T> operator T &() const;
+};
+
+template<typename T, typename Indexes, typename = void>
+struct brace_constructible : std::false_type {};
+
+template<typename T, size_t... I>
+struct brace_constructible<T, std::index_sequence<I...>,
+  std::void_t<decltype(T{(void(I), std::declval<any_field>())...})>> : std::true_type {};
+
+template<typename T, size_t N = 8>
+constexpr size_t field_count() {
+  if constexpr (N == 0) return 0;
+  else if constexpr (brace_constructible<T, std::make_index_sequence<N>>::value) return N;
+  else return field_count<T, N - 1>();
+}
+
+// calls f on each field of an aggregate, in declaration order
+template<typename T, typename F>
+void for_each_field(T &t, F &&f) {
+  constexpr size_t n = field_count<std::remove_const_t<T>>();
+  static_assert(n > 0, "the native serializer supports aggregates of 1 to 8 fields");
+  if constexpr (n == 1) { auto &[a] = t; f(a); }
+  else if constexpr (n == 2) { auto &[a, b] = t; f(a); f(b); }
+  else if constexpr (n == 3) { auto &[a, b, c] = t; f(a); f(b); f(c); }
+  else if constexpr (n == 4) { auto &[a, b, c, d] = t; f(a); f(b); f(c); f(d); }
+  else if constexpr (n == 5) { auto &[a, b, c, d, e] = t; f(a); f(b); f(c); f(d); f(e); }
+  else if constexpr (n == 6) { auto &[a, b, c, d, e, g] = t; f(a); f(b); f(c); f(d); f(e); f(g); }
+  else if constexpr (n == 7) { auto &[a, b, c, d, e, g, h] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); }
+  else { auto &[a, b, c, d, e, g, h, i] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); }
+}
+
+template<typename T> struct is_vector : std::false_type {};
+template<typename T> struct is_vector<std::vector<T>> : std::true_type {};
+template<typename T> struct is_binary_extension : std::false_type {};
+template<typename T> struct is_binary_extension<binary_extension<T>> : std::true_type {};
+template<typename T> struct is_optional : std::false_type {};
+template<typename T> struct is_optional<std::optional<T>> : std::true_type {};
+template<typename T> struct is_tuple : std::false_type {};
+template<typename... T> struct is_tuple<std::tuple<T...>> : std::true_type {};
+template<typename A, typename B> struct is_tuple<std::pair<A, B>> : std::true_type {};
+
+struct writer {
+  std::vector<char> bytes;
+
+  void write(const void *data, size_t size) {
+    const char *p = static_cast<const char *>(data);
+    bytes.insert(bytes.end(), p, p + size);
+  }
+
+  void varuint32(uint32_t v) {
+    do {
+      uint8_t b = v & 0x7f;
+      v >>= 7;
+      b |= uint8_t((v > 0) << 7);
+      bytes.push_back(char(b));
+    } while (v != 0);
+  }
+};
+
+struct reader {
+  const char *pos;
+  const char *end;
+
+  size_t remaining() const { return size_t(end - pos); }
+
+  void read(void *data, size_t size) {
+    check(remaining() >= size, "datastream attempted to read past the end");
+    std::memcpy(data, pos, size);
+    pos += size;
+  }
+
+  uint32_t varuint32() {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      uint8_t b;
+      read(&b, 1);
+      v |= uint32_t(b & 0x7f) << shift;
+      if (!(b & 0x80)) return v;
+    }
+    check(false, "varuint32 is too long");
+    return 0;
+  }
+};
+
+template<typename T>
+void write_value(writer &w, const T &v) {
+  if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+    w.write(&v, sizeof(v));
+  } else if constexpr (std::is_same_v<T, name>) {
+    w.write(&v.value, 8);
+  } else if constexpr (std::is_same_v<T, symbol_code> || std::is_same_v<T, symbol>) {
+    uint64_t raw = v.raw();
+    w.write(&raw, 8);
+  } else if constexpr (std::is_same_v<T, extended_symbol>) {
+    write_value(w, v.get_symbol());
+    write_value(w, v.get_contract());
+  } else if constexpr (std::is_same_v<T, asset>) {
+    write_value(w, v.amount);
+    write_value(w, v.symbol);
+  } else if constexpr (std::is_same_v<T, microseconds>) {
+    write_value(w, v.count());
+  } else if constexpr (std::is_same_v<T, time_point>) {
+    write_value(w, v.time_since_epoch().count());
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    w.varuint32(uint32_t(v.size()));
+    w.write(v.data(), v.size());
+  } else if constexpr (is_vector<T>::value) {
+    w.varuint32(uint32_t(v.size()));
+    for (const auto &item : v) write_value(w, item);
+  } else if constexpr (is_binary_extension<T>::value) {
+    if (v.has_value()) write_value(w, v.value());
+  } else if constexpr (is_optional<T>::value) {
+    write_value(w, bool(v.has_value()));
+    if (v.has_value()) write_value(w, *v);
+  } else if constexpr (is_tuple<T>::value) {
+    std::apply([&](const auto &... items) { (write_value(w, items), ...); }, v);
+  } else if constexpr (std::is_array_v<T>) {
+    for (const auto &item : v) write_value(w, item);
+  } else {
+    static_assert(std::is_aggregate_v<T>, "the native serializer has no rule for this type");
+    for_each_field(v, [&](const auto &field) { write_value(w, field); });
+  }
+}
+
+template<typename T>
+void read_value(reader &r, T &v) {
+  if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+    r.read(&v, sizeof(v));
+  } else if constexpr (std::is_same_v<T, name>) {
+    r.read(&v.value, 8);
+  } else if constexpr (std::is_same_v<T, symbol_code> || std::is_same_v<T, symbol>) {
+    uint64_t raw;
+    r.read(&raw, 8);
+    v = T(raw);
+  } else if constexpr (std::is_same_v<T, extended_symbol>) {
+    symbol s;
+    name c;
+    read_value(r, s);
+    read_value(r, c);
+    v = extended_symbol(s, c);
+  } else if constexpr (std::is_same_v<T, asset>) {
+    read_value(r, v.amount);
+    read_value(r, v.symbol);
+  } else if constexpr (std::is_same_v<T, microseconds>) {
+    int64_t count;
+    read_value(r, count);
+    v = microseconds(count);
+  } else if constexpr (std::is_same_v<T, time_point>) {
+    int64_t count;
+    read_value(r, count);
+    v = time_point(microseconds(count));
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    uint32_t size = r.varuint32();
+    check(r.remaining() >= size, "datastream attempted to read past the end");
+    v.assign(r.pos, size);
+    r.pos += size;
+  } else if constexpr (is_vector<T>::value) {
+    uint32_t size = r.varuint32();
+    v.clear();
+    for (uint32_t i = 0; i < size; i++) {
+      typename T::value_type item{};
+      read_value(r, item);
+      v.push_back(std::move(item));
+    }
+  } else if constexpr (is_binary_extension<T>::value) {
+    if (r.remaining() > 0) {
+      std::decay_t<decltype(v.value())> item{};
+      read_value(r, item);
+      v.emplace(std::move(item));
+    } else {
+      v.reset();
+    }
+  } else if constexpr (is_optional<T>::value) {
+    bool present;
+    read_value(r, present);
+    v.reset();
+    if (present) read_value(r, v.emplace());
+  } else if constexpr (is_tuple<T>::value) {
+    std::apply([&](auto &... items) { (read_value(r, items), ...); }, v);
+  } else {
+    static_assert(std::is_aggregate_v<T>, "the native serializer has no rule for this type");
+    for_each_field(v, [&](auto &field) { read_value(r, field); });
+  }
+}
+
+} // namespace native
+
+template<typename T>
+std::vector<char> pack(const T &v) {
+  native::writer w;
+  native::write_value(w, v);
+  return std::move(w.bytes);
+}
+
+template<typename T>
+size_t pack_size(const T &v) {
+  return pack(v).size();
+}
+
+template<typename T>
+T unpack(const char *data, size_t size) {
+  native::reader r{data, data + size};
+  T v{};
+  native::read_value(r, v);
+  return v;
+}
+
+template<typename T>
+T unpack(const std::vector<char> &bytes) {
+  return unpack<T>(bytes.data(), bytes.size());
+}
+
+template<typename T>
+class datastream {
+  T start;
+  T pos;
+  size_t size;
+
+public:
+  datastream(T s, size_t n) : start(s), pos(s), size(n) {}
+
+  T pos_ptr() const { return pos; }
+  size_t remaining() const { return size - size_t(pos - start); }
+  size_t tellp() const { return size_t(pos - start); }
+};
+
+
+// CRYPTO
+
+struct checksum256 {
+  std::array<uint8_t, 32> bytes{};
+
+  std::array<uint8_t, 32> extract_as_byte_array() const { return bytes; }
+
+  friend bool operator==(const checksum256 &a, const checksum256 &b) { return a.bytes == b.bytes; }
+  friend bool operator!=(const checksum256 &a, const checksum256 &b) { return a.bytes != b.bytes; }
+};
+
+inline checksum256 sha256(const char *data, uint32_t length) {
+  static const uint32_t k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+  uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  auto rotate = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+
+  std::vector<uint8_t> message(data, data + length);
+  message.push_back(0x80);
+  while (message.size() % 64 != 56) message.push_back(0);
+  uint64_t bits = uint64_t(length) * 8;
+  for (int i = 7; i >= 0; i--) message.push_back(uint8_t(bits >> (8 * i)));
+
+  for (size_t block = 0; block < message.size(); block += 64) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+      const uint8_t *p = &message[block + 4 * i];
+      w[i] = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+    }
+    for (int i = 16; i < 64; i++) {
+      uint32_t s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      uint32_t s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+    for (int i = 0; i < 64; i++) {
+      uint32_t t1 = hh + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+      uint32_t t2 = (rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+      hh = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+  }
+
+  checksum256 digest;
+  for (int i = 0; i < 8; i++) {
+    for (int j = 0; j < 4; j++) digest.bytes[4 * i + j] = uint8_t(h[i] >> (24 - 8 * j));
+  }
+  return digest;
+}
+
+
+// HOST STATE
+
+struct permission_level {
+  name actor;
+  name permission;
+};
+
+namespace native {
+
+// RAM billed by the chain for each row, on top of its serialized size, and for each secondary index entry and
+// each table (nodeos chain/config.hpp and contract_table_objects.hpp: key_value_object, index64_object and
+// table_id_object with 32 bytes of overhead per index)
+const int64_t ROW_RAM_BYTES = 108;
+const int64_t INDEX_ENTRY_RAM_BYTES = 128;
+const int64_t TABLE_RAM_BYTES = 108;
+
+// the database intrinsics called by the CDT's multi_index, in groups
+struct intrinsic_counts {
+  uint32_t lookups = 0;       // db_find_i64, db_lowerbound_i64, db_upperbound_i64, db_end_i64
+  uint32_t steps = 0;         // db_next_i64, db_previous_i64
+  uint32_t reads = 0;         // db_get_i64
+  uint32_t writes = 0;        // db_store_i64, db_update_i64, db_remove_i64
+  uint32_t idx_lookups = 0;   // db_idx64_find_primary, db_idx64_find_secondary, db_idx64_lowerbound, ...
+  uint32_t idx_steps = 0;     // db_idx64_next, db_idx64_previous
+  uint32_t idx_writes = 0;    // db_idx64_store, db_idx64_update, db_idx64_remove
+
+  uint32_t total() const { return lookups + steps + reads + writes + idx_lookups + idx_steps + idx_writes; }
+};
+
+struct sent_action {
+  name account;
+  name action;
+  std::vector<permission_level> authorization;
+  std::vector<char> data;
+};
+
+struct stored_row {
+  std::any object;
+  uint32_t size;   // serialized size
+  name payer;
+  std::vector<char> (*packed)(const std::any &object);   // the row as the chain stores it
+};
+
+// (code, scope, table); a secondary index is the table name with its index number in the low 4 bits
+using table_id = std::tuple<uint64_t, uint64_t, uint64_t>;
+
+struct table_rows {
+  std::map<uint64_t, stored_row> rows;
+  name payer;   // billed for the table itself
+};
+
+struct index_rows {
+  std::set<std::pair<uint64_t, uint64_t>> by_secondary;   // (secondary key, primary key)
+  std::map<uint64_t, uint64_t> by_primary;                // primary key -> secondary key
+  name payer;
+};
+
+class host_state {
+public:
+  int64_t now_us = 0;
+  std::vector<name> auths;
+  std::string console;
+  std::vector<sent_action> sent;
+  intrinsic_counts intrinsics;
+
+  std::map<table_id, table_rows> tables;
+  std::map<table_id, index_rows> indexes;
+  std::map<uint64_t, int64_t> ram;   // bytes billed to each payer
+
+  // clears the chain
+  void reset() {
+    *this = host_state();
+  }
+
+  // starts an action with the authorizations given: the console, inline actions, counts and undo log restart
+  void begin_action(std::vector<name> authorizations) {
+    auths = std::move(authorizations);
+    console.clear();
+    sent.clear();
+    intrinsics = intrinsic_counts();
+    undo_log.clear();
+  }
+
+  void commit() { undo_log.clear(); }
+
+  // undoes the table writes of the current action
+  void revert() {
+    while (!undo_log.empty()) {
+      undo_log.back()();
+      undo_log.pop_back();
+    }
+    sent.clear();
+  }
+
+  // PRIMARY ROWS
+
+  const table_rows *find_table(const table_id &t) const {
+    auto itr = tables.find(t);
+    return itr == tables.end() ? nullptr : &itr->second;
+  }
+
+  stored_row *find_row(const table_id &t, uint64_t pk) {
+    auto table = tables.find(t);
+    if (table == tables.end()) return nullptr;
+    auto row = table->second.rows.find(pk);
+    return row == table->second.rows.end() ? nullptr : &row->second;
+  }
+
+  void store_row(const table_id &t, uint64_t pk, std::any object, uint32_t size, name payer,
+    std::vector<char> (*packed)(const std::any &)) {
+    auto table = tables.find(t);
+    if (table == tables.end()) {
+      table = tables.emplace(t, table_rows{{}, payer}).first;
+      bill(payer, TABLE_RAM_BYTES);
+    }
+    check(table->second.rows.emplace(pk, stored_row{std::move(object), size, payer, packed}).second,
+      "could not insert object, most likely a uniqueness constraint was violated");
+    bill(payer, ROW_RAM_BYTES + size);
+
+    undo_log.push_back([this, t, pk] { remove_row(t, pk, false); });
+  }
+
+  template<typename T>
+  void update_row(const table_id &t, uint64_t pk, const T &object, uint32_t size, name payer) {
+    stored_row &row = *find_row(t, pk);
+    stored_row previous = row;
+
+    bill(row.payer, -(ROW_RAM_BYTES + int64_t(row.size)));
+    bill(payer, ROW_RAM_BYTES + size);
+    // assigned in place, so that references to the row see the new values, as with the CDT's object cache
+    *std::any_cast<T>(&row.object) = object;
+    row.size = size;
+    row.payer = payer;
+
+    undo_log.push_back([this, t, pk, previous] {
+      stored_row &r = *find_row(t, pk);
+      bill(r.payer, -(ROW_RAM_BYTES + int64_t(r.size)));
+      bill(previous.payer, ROW_RAM_BYTES + previous.size);
+      r = previous;
+    });
+  }
+
+  void remove_row(const table_id &t, uint64_t pk, bool logged = true) {
+    auto table = tables.find(t);
+    auto row = table->second.rows.find(pk);
+    stored_row previous = row->second;
+    name table_payer = table->second.payer;
+
+    bill(previous.payer, -(ROW_RAM_BYTES + int64_t(previous.size)));
+    table->second.rows.erase(row);
+    if (table->second.rows.empty()) {
+      bill(table_payer, -TABLE_RAM_BYTES);
+      tables.erase(table);
+    }
+
+    if (logged) {
+      undo_log.push_back([this, t, pk, previous, table_payer] {
+        auto restored = tables.find(t);
+        if (restored == tables.end()) {
+          restored = tables.emplace(t, table_rows{{}, table_payer}).first;
+          bill(table_payer, TABLE_RAM_BYTES);
+        }
+        restored->second.rows.emplace(pk, previous);
+        bill(previous.payer, ROW_RAM_BYTES + previous.size);
+      });
+    }
+  }
+
+  // SECONDARY INDEX ENTRIES
+
+  const index_rows *find_index(const table_id &t) const {
+    auto itr = indexes.find(t);
+    return itr == indexes.end() ? nullptr : &itr->second;
+  }
+
+  std::optional<uint64_t> secondary_of(const table_id &t, uint64_t pk) const {
+    const index_rows *index = find_index(t);
+    if (index == nullptr) return std::nullopt;
+    auto entry = index->by_primary.find(pk);
+    if (entry == index->by_primary.end()) return std::nullopt;
+    return entry->second;
+  }
+
+  void store_entry(const table_id &t, uint64_t pk, uint64_t secondary, name payer, bool logged = true) {
+    auto index = indexes.find(t);
+    if (index == indexes.end()) {
+      index = indexes.emplace(t, index_rows{{}, {}, payer}).first;
+      bill(payer, TABLE_RAM_BYTES);
+    }
+    index->second.by_secondary.insert({secondary, pk});
+    index->second.by_primary[pk] = secondary;
+    bill(payer, INDEX_ENTRY_RAM_BYTES);
+
+    if (logged) undo_log.push_back([this, t, pk] { remove_entry(t, pk, false); });
+  }
+
+  void update_entry(const table_id &t, uint64_t pk, uint64_t secondary, name payer) {
+    uint64_t previous = *secondary_of(t, pk);
+    name previous_payer = indexes[t].payer;
+    remove_entry(t, pk, false);
+    store_entry(t, pk, secondary, payer, false);
+
+    undo_log.push_back([this, t, pk, previous, previous_payer] {
+      remove_entry(t, pk, false);
+      store_entry(t, pk, previous, previous_payer, false);
+    });
+  }
+
+  void remove_entry(const table_id &t, uint64_t pk, bool logged = true) {
+    auto index = indexes.find(t);
+    uint64_t secondary = index->second.by_primary.at(pk);
+    name payer = index->second.payer;
+
+    index->second.by_secondary.erase({secondary, pk});
+    index->second.by_primary.erase(pk);
+    bill(payer, -INDEX_ENTRY_RAM_BYTES);
+    if (index->second.by_primary.empty()) {
+      bill(payer, -TABLE_RAM_BYTES);
+      indexes.erase(index);
+    }
+
+    if (logged) undo_log.push_back([this, t, pk, secondary, payer] { store_entry(t, pk, secondary, payer, false); });
+  }
+
+  int64_t ram_of(name payer) const {
+    auto itr = ram.find(payer.value);
+    return itr == ram.end() ? 0 : itr->second;
+  }
+
+private:
+  std::vector<std::function<void()>> undo_log;
+
+  void bill(name payer, int64_t bytes) { ram[payer.value] += bytes; }
+};
+
+inline host_state &host() {
+  static host_state state;
+  return state;
+}
+
+} // namespace native
+
+
+// CHAIN API
+
+inline time_point current_time_point() {
+  return time_point(microseconds(native::host().now_us));
+}
+
+inline bool has_auth(name account) {
+  const auto &auths = native::host().auths;
+  return std::find(auths.begin(), auths.end(), account) != auths.end();
+}
+
+inline void require_auth(name account) {
+  check(has_auth(account), "missing authority of " + account.to_string());
+}
+
+inline bool is_account(name account) {
+  return account.value != 0;
+}
+
+inline void print(const char *s) { native::host().console += s; }
+inline void print(const std::string &s) { native::host().console += s; }
+inline void print(char *s) { native::host().console += s; }
+
+template<typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+void print(T v) {
+  if constexpr (std::is_same_v<T, bool>) native::host().console += v ? "true" : "false";
+  else if constexpr (std::is_same_v<T, char>) native::host().console += v;
+  else native::host().console += std::to_string(v);
+}
+
+template<typename T>
+auto print(const T &v) -> decltype(v.print(), void()) {
+  v.print();
+}
+
+template<typename First, typename Second, typename... Rest>
+void print(First &&first, Second &&second, Rest &&... rest) {
+  print(std::forward<First>(first));
+  print(std::forward<Second>(second), std::forward<Rest>(rest)...);
+}
+
+inline void name::print() const { native::host().console += to_string(); }
+inline void asset::print() const { native::host().console += to_string(); }
+
+struct action {
+  name account;
+  name action_name;
+  std::vector<permission_level> authorization;
+  std::vector<char> data;
+
+  template<typename T>
+  action(const permission_level &auth, name a, name n, T &&value)
+    : account(a), action_name(n), authorization{auth}, data(pack(std::forward<T>(value))) {}
+
+  template<typename T>
+  action(std::vector<permission_level> auths, name a, name n, T &&value)
+    : account(a), action_name(n), authorization(std::move(auths)), data(pack(std::forward<T>(value))) {}
+
+  void send() const {
+    native::host().sent.push_back({account, action_name, authorization, data});
+  }
+};
+
+template<name::raw Name, auto Action>
+struct action_wrapper {
+  static constexpr name action_name = name(Name);
+};
+
+class contract {
+public:
+  contract(name self, name first_receiver, datastream<const char *> ds) : _self(self), _first_receiver(first_receiver), _ds(ds) {}
+
+  name get_self() const { return _self; }
+  name get_first_receiver() const { return _first_receiver; }
+  datastream<const char *> &get_datastream() { return _ds; }
+
+protected:
+  name _self;
+  name _first_receiver;
+  datastream<const char *> _ds;
+};
+
+} // namespace eosio
+
+#include "multi_index.hpp"
@@ -0,0 +1,440 @@
+#pragma once
+
+// Native multi_index for the host in eosio.hpp.
+//
+// Rows live in native::host(), as objects with their serialized size, and each secondary index is a table of
+// (secondary key, primary key) entries named like the chain names it: the table name with the index number in its
+// low 4 bits. Only uint64_t secondary keys are supported, which is all the contract uses.
+//
+// Each multi_index object keeps the primary keys it has loaded, like the CDT's object cache, so that the
+// database intrinsics are counted as the CDT would call them: a find of a loaded row costs nothing, moving an
+// iterator costs a db_next_i64 or db_previous_i64 and a db_get_i64 for a row not loaded yet, and a write costs a
+// primary write and one secondary write for each index whose key is stored or changed.
+
+#include <eosio/eosio.hpp>
+
+namespace eosio {
+
+template<typename T, typename Result, Result (T::*Method)() const>
+struct const_mem_fun {
+  typedef Result result_type;
+
+  Result operator()(const T &obj) const { return (obj.*Method)(); }
+};
+
+template<name::raw IndexName, typename Extractor>
+struct indexed_by {
+  static constexpr name::raw index_name = IndexName;
+  typedef Extractor secondary_extractor_type;
+};
+
+template<name::raw TableName, typename T, typename... Indices>
+class multi_index {
+public:
+  template<size_t Number, typename IndexDef>
+  class index;
+
+  class const_iterator {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = const T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = const T &;
+
+    const_iterator() = default;
+
+    const T &operator*() const {
+      check(!at_end, "cannot dereference end iterator");
+      return table->object(pk);
+    }
+    const T *operator->() const { return &**this; }
+
+    const_iterator &operator++() {
+      check(!at_end, "cannot increment end iterator");
+      native::host().intrinsics.steps++;
+      const native::table_rows *rows = native::host().find_table(table->id());
+      auto next = rows->rows.upper_bound(pk);
+      if (next == rows->rows.end()) {
+        at_end = true;
+      } else {
+        pk = next->first;
+        table->load(pk);
+      }
+      return *this;
+    }
+
+    const_iterator &operator--() {
+      const native::table_rows *rows = native::host().find_table(table->id());
+      native::host().intrinsics.steps++;
+      if (at_end) {
+        native::host().intrinsics.lookups++;   // db_end_i64
+        check(rows != nullptr && !rows->rows.empty(), "cannot decrement end iterator when the table is empty");
+        pk = rows->rows.rbegin()->first;
+        at_end = false;
+      } else {
+        auto current = rows->rows.find(pk);
+        check(current != rows->rows.begin(), "cannot decrement iterator at beginning of table");
+        pk = std::prev(current)->first;
+      }
+      table->load(pk);
+      return *this;
+    }
+
+    const_iterator operator++(int) { const_iterator previous = *this; ++(*this); return previous; }
+    const_iterator operator--(int) { const_iterator previous = *this; --(*this); return previous; }
+
+    friend bool operator==(const const_iterator &a, const const_iterator &b) {
+      return a.at_end == b.at_end && (a.at_end || a.pk == b.pk);
+    }
+    friend bool operator!=(const const_iterator &a, const const_iterator &b) { return !(a == b); }
+
+  private:
+    friend class multi_index;
+
+    const_iterator(const multi_index *t, uint64_t key, bool end) : table(t), pk(key), at_end(end) {}
+
+    const multi_index *table = nullptr;
+    uint64_t pk = 0;
+    bool at_end = true;
+  };
+
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  multi_index(name code, uint64_t scope) : _code(code), _scope(scope) {}
+
+  name get_code() const { return _code; }
+  uint64_t get_scope() const { return _scope; }
+
+  const_iterator begin() const {
+    native::host().intrinsics.lookups++;   // db_lowerbound_i64
+    const native::table_rows *rows = native::host().find_table(id());
+    if (rows == nullptr) return end();
+    load(rows->rows.begin()->first);
+    return const_iterator(this, rows->rows.begin()->first, false);
+  }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator end() const { return const_iterator(this, 0, true); }
+  const_iterator cend() const { return end(); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  const_iterator find(uint64_t primary) const {
+    bool cached = loaded.count(primary) > 0;
+    if (!cached) native::host().intrinsics.lookups++;   // db_find_i64
+    if (native::host().find_row(id(), primary) == nullptr) return end();
+    load(primary);
+    return const_iterator(this, primary, false);
+  }
+
+  const_iterator require_find(uint64_t primary, const char *error_msg = "unable to find key") const {
+    auto itr = find(primary);
+    check(itr != end(), error_msg);
+    return itr;
+  }
+
+  const T &get(uint64_t primary, const char *error_msg = "unable to find key") const {
+    return *require_find(primary, error_msg);
+  }
+
+  const_iterator lower_bound(uint64_t primary) const { return bound(primary, false); }
+  const_iterator upper_bound(uint64_t primary) const { return bound(primary, true); }
+
+  uint64_t available_primary_key() const {
+    native::host().intrinsics.lookups++;   // db_end_i64
+    const native::table_rows *rows = native::host().find_table(id());
+    if (rows == nullptr) return 0;
+    native::host().intrinsics.steps++;     // db_previous_i64
+    check(rows->rows.rbegin()->first < std::numeric_limits<uint64_t>::max(), "next primary key in table is at autoincrement limit");
+    return rows->rows.rbegin()->first + 1;
+  }
+
+  const_iterator iterator_to(const T &obj) const {
+    return const_iterator(this, obj.primary_key(), false);
+  }
+
+  template<typename Lambda>
+  const_iterator emplace(name payer, Lambda &&constructor) {
+    check(payer.value != 0, "must specify a valid account to pay for new record");
+
+    T obj{};
+    constructor(obj);
+    uint64_t pk = obj.primary_key();
+    uint32_t size = uint32_t(pack_size(obj));
+
+    native::host().intrinsics.writes++;   // db_store_i64
+    native::host().store_row(id(), pk, std::any(std::move(obj)), size, payer,
+      [](const std::any &row) { return pack(std::any_cast<const T &>(row)); });
+    const T &stored = object(pk);
+    for_each_index([&](size_t number, uint64_t secondary) {
+      native::host().intrinsics.idx_writes++;   // db_idx64_store
+      native::host().store_entry(index_id(number), pk, secondary, payer);
+    }, stored);
+
+    loaded.insert(pk);
+    known_index_entries[pk] = ~0u;
+    return const_iterator(this, pk, false);
+  }
+
+  template<typename Lambda>
+  void modify(const_iterator itr, name payer, Lambda &&updater) {
+    check(!itr.at_end, "cannot pass end iterator to modify");
+    modify(*itr, payer, std::forward<Lambda>(updater));
+  }
+
+  template<typename Lambda>
+  void modify(const T &obj, name payer, Lambda &&updater) {
+    uint64_t pk = obj.primary_key();
+    native::stored_row *row = native::host().find_row(id(), pk);
+    check(row != nullptr && std::any_cast<T>(&row->object) == &obj, "object passed to modify is not in multi_index");
+
+    std::vector<uint64_t> previous_keys;
+    for_each_index([&](size_t, uint64_t secondary) { previous_keys.push_back(secondary); }, obj);
+
+    T updated = obj;
+    updater(updated);
+    check(updated.primary_key() == pk, "updater cannot change primary key when modifying an object");
+
+    name row_payer = payer.value != 0 ? payer : row->payer;
+    native::host().intrinsics.writes++;   // db_update_i64
+    native::host().update_row(id(), pk, updated, uint32_t(pack_size(updated)), row_payer);
+
+    for_each_index([&](size_t number, uint64_t secondary) {
+      if (secondary == previous_keys[number]) return;
+      find_index_entry(pk, number);
+      check(native::host().secondary_of(index_id(number), pk).has_value(), "invalid secondary index iterator");
+      native::host().intrinsics.idx_writes++;   // db_idx64_update
+      native::host().update_entry(index_id(number), pk, secondary, row_payer);
+    }, obj);
+  }
+
+  const_iterator erase(const_iterator itr) {
+    check(!itr.at_end, "cannot pass end iterator to erase");
+    const_iterator next = itr;
+    ++next;
+    erase(*itr);
+    return next;
+  }
+
+  void erase(const T &obj) {
+    uint64_t pk = obj.primary_key();
+    native::stored_row *row = native::host().find_row(id(), pk);
+    check(row != nullptr && std::any_cast<T>(&row->object) == &obj, "object passed to erase is not in multi_index");
+
+    for (size_t number = 0; number < sizeof...(Indices); number++) {
+      find_index_entry(pk, number);
+      if (native::host().secondary_of(index_id(number), pk).has_value()) {
+        native::host().intrinsics.idx_writes++;   // db_idx64_remove
+        native::host().remove_entry(index_id(number), pk);
+      }
+    }
+
+    native::host().intrinsics.writes++;   // db_remove_i64
+    native::host().remove_row(id(), pk);
+    loaded.erase(pk);
+    known_index_entries.erase(pk);
+  }
+
+  template<name::raw IndexName>
+  auto get_index() const {
+    constexpr size_t number = index_number<IndexName>();
+    using definition = std::tuple_element_t<number, std::tuple<Indices...>>;
+    return index<number, definition>(this);
+  }
+
+  template<size_t Number, typename IndexDef>
+  class index {
+  public:
+    using secondary_key_type = typename IndexDef::secondary_extractor_type::result_type;
+    static_assert(std::is_same_v<secondary_key_type, uint64_t>, "the native multi_index supports uint64_t secondary keys");
+
+    class const_iterator {
+    public:
+      using iterator_category = std::bidirectional_iterator_tag;
+      using value_type = const T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const T *;
+      using reference = const T &;
+
+      const_iterator() = default;
+
+      const T &operator*() const {
+        check(!at_end, "cannot dereference end iterator");
+        return idx->table->object(entry.second);
+      }
+      const T *operator->() const { return &**this; }
+
+      const_iterator &operator++() {
+        check(!at_end, "cannot increment end iterator");
+        native::host().intrinsics.idx_steps++;   // db_idx64_next
+        const native::index_rows *entries = native::host().find_index(idx->id());
+        auto next = entries->by_secondary.upper_bound(entry);
+        if (next == entries->by_secondary.end()) {
+          at_end = true;
+        } else {
+          entry = *next;
+          idx->load(entry.second);
+        }
+        return *this;
+      }
+
+      const_iterator &operator--() {
+        const native::index_rows *entries = native::host().find_index(idx->id());
+        native::host().intrinsics.idx_steps++;   // db_idx64_previous
+        if (at_end) {
+          native::host().intrinsics.idx_lookups++;   // db_idx64_end
+          check(entries != nullptr && !entries->by_secondary.empty(), "cannot decrement end iterator when the index is empty");
+          entry = *entries->by_secondary.rbegin();
+          at_end = false;
+        } else {
+          auto current = entries->by_secondary.find(entry);
+          check(current != entries->by_secondary.begin(), "cannot decrement iterator at beginning of index");
+          entry = *std::prev(current);
+        }
+        idx->load(entry.second);
+        return *this;
+      }
+
+      const_iterator operator++(int) { const_iterator previous = *this; ++(*this); return previous; }
+      const_iterator operator--(int) { const_iterator previous = *this; --(*this); return previous; }
+
+      friend bool operator==(const const_iterator &a, const const_iterator &b) {
+        return a.at_end == b.at_end && (a.at_end || a.entry == b.entry);
+      }
+      friend bool operator!=(const const_iterator &a, const const_iterator &b) { return !(a == b); }
+
+    private:
+      friend class index;
+
+      const_iterator(const index *i, std::pair<uint64_t, uint64_t> e, bool end) : idx(i), entry(e), at_end(end) {}
+
+      const index *idx = nullptr;
+      std::pair<uint64_t, uint64_t> entry;   // (secondary key, primary key)
+      bool at_end = true;
+    };
+
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    explicit index(const multi_index *t) : table(t) {}
+
+    name get_code() const { return table->get_code(); }
+    uint64_t get_scope() const { return table->get_scope(); }
+
+    const_iterator begin() const { return bound(0, false); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator end() const { return const_iterator(this, {0, 0}, true); }
+    const_iterator cend() const { return end(); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    const_iterator lower_bound(uint64_t secondary) const { return bound(secondary, false); }
+    const_iterator upper_bound(uint64_t secondary) const { return bound(secondary, true); }
+
+    const_iterator find(uint64_t secondary) const {
+      auto itr = lower_bound(secondary);
+      if (itr == end() || itr.entry.first != secondary) return end();
+      return itr;
+    }
+
+    const_iterator iterator_to(const T &obj) const {
+      uint64_t pk = obj.primary_key();
+      table->find_index_entry(pk, Number);
+      auto secondary = native::host().secondary_of(id(), pk);
+      check(secondary.has_value(), "unable to find secondary key");
+      return const_iterator(this, {*secondary, pk}, false);
+    }
+
+    template<typename Lambda>
+    void modify(const_iterator itr, name payer, Lambda &&updater) {
+      check(!itr.at_end, "cannot pass end iterator to modify");
+      const_cast<multi_index *>(table)->modify(*itr, payer, std::forward<Lambda>(updater));
+    }
+
+    const_iterator erase(const_iterator itr) {
+      check(!itr.at_end, "cannot pass end iterator to erase");
+      const_iterator next = itr;
+      ++next;
+      const_cast<multi_index *>(table)->erase(*itr);
+      return next;
+    }
+
+  private:
+    const multi_index *table;
+
+    native::table_id id() const { return table->index_id(Number); }
+
+    void load(uint64_t pk) const {
+      if (table->loaded.count(pk) == 0) native::host().intrinsics.lookups++;   // db_find_i64 of the row
+      table->load(pk);
+      table->known_index_entries[pk] |= 1u << Number;
+    }
+
+    const_iterator bound(uint64_t secondary, bool upper) const {
+      native::host().intrinsics.idx_lookups++;   // db_idx64_lowerbound or db_idx64_upperbound
+      const native::index_rows *entries = native::host().find_index(id());
+      if (entries == nullptr) return end();
+      auto found = upper ? entries->by_secondary.upper_bound({secondary, std::numeric_limits<uint64_t>::max()})
+                         : entries->by_secondary.lower_bound({secondary, 0});
+      if (found == entries->by_secondary.end()) return end();
+      load(found->second);
+      return const_iterator(this, *found, false);
+    }
+  };
+
+private:
+  name _code;
+  uint64_t _scope;
+
+  // the primary keys of the rows this object has loaded, and the indexes whose entry for the row it holds
+  mutable std::set<uint64_t> loaded;
+  mutable std::map<uint64_t, uint32_t> known_index_entries;
+
+  native::table_id id() const { return {_code.value, _scope, uint64_t(TableName)}; }
+
+  native::table_id index_id(size_t number) const {
+    return {_code.value, _scope, (uint64_t(TableName) & 0xFFFFFFFFFFFFFFF0ULL) | (number & 0x0F)};
+  }
+
+  const T &object(uint64_t pk) const {
+    native::stored_row *row = native::host().find_row(id(), pk);
+    check(row != nullptr, "dereference of deleted object");
+    return *std::any_cast<T>(&row->object);
+  }
+
+  void load(uint64_t pk) const {
+    if (loaded.insert(pk).second) native::host().intrinsics.reads++;   // db_get_i64
+  }
+
+  // looks up the index entry of a row, unless this object already holds it
+  void find_index_entry(uint64_t pk, size_t number) const {
+    uint32_t &known = known_index_entries[pk];
+    if (known & (1u << number)) return;
+    native::host().intrinsics.idx_lookups++;   // db_idx64_find_primary
+    known |= 1u << number;
+  }
+
+  const_iterator bound(uint64_t primary, bool upper) const {
+    native::host().intrinsics.lookups++;   // db_lowerbound_i64 or db_upperbound_i64
+    const native::table_rows *rows = native::host().find_table(id());
+    if (rows == nullptr) return end();
+    auto found = upper ? rows->rows.upper_bound(primary) : rows->rows.lower_bound(primary);
+    if (found == rows->rows.end()) return end();
+    load(found->first);
+    return const_iterator(this, found->first, false);
+  }
+
+  template<typename F>
+  void for_each_index(F &&f, const T &obj) const {
+    size_t number = 0;
+    (f(number++, uint64_t(typename Indices::secondary_extractor_type()(obj))), ...);
+  }
+
+  template<name::raw IndexName, size_t Number = 0>
+  static constexpr size_t index_number() {
+    static_assert(Number < sizeof...(Indices), "the table has no index of that name");
+    if constexpr (std::tuple_element_t<Number, std::tuple<Indices...>>::index_name == IndexName) return Number;
+    else return index_number<IndexName, Number + 1>();
+  }
+};
+
+} // namespace eosio
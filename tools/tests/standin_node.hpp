@@ -0,0 +1,287 @@
+#pragma once
+
+// In-process stand-in for the chain API endpoints that the native tools read, for their tests.
+//
+// The node holds packed table rows, as recorded from a node or packed by the test, and answers
+// /v1/chain/get_table_rows ("json": false, i64 keys) and /v1/chain/get_table_by_scope from them over HTTP/1.1 on a
+// loopback port. Requests that arrive together are answered together once the connection has been idle for
+// IDLE_MS, and each such batch is counted as one round trip, so tests can check how many round trips a tool needs.
+
+#include "../cronacle_client.hpp"
+
+#include <netinet/in.h>
+#include <poll.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace cronacle_standin {
+
+using cronacle_client::name_string;
+using cronacle_client::name_value;
+
+// a scope given as a string: a number, as season scopes are written, or an account name
+inline uint64_t scope_value(const std::string &text) {
+  bool numeric = !text.empty() && text.find_first_not_of("0123456789") == std::string::npos;
+  return numeric ? std::stoull(text) : name_value(text);
+}
+
+// the value of a field in a flat JSON object, without its quotes; empty if the field is absent
+inline std::string json_field(const std::string &body, const std::string &key) {
+  size_t at = body.find("\"" + key + "\"");
+  if (at == std::string::npos) return "";
+  size_t value = body.find_first_not_of(" :", at + key.size() + 2);
+  if (body[value] == '"') return body.substr(value + 1, body.find('"', value + 1) - value - 1);
+  return body.substr(value, body.find_first_of(",}", value) - value);
+}
+
+inline std::string to_hex(const std::vector<uint8_t> &bytes) {
+  static const char *digits = "0123456789abcdef";
+  std::string hex;
+  for (uint8_t b : bytes) {
+    hex += digits[b >> 4];
+    hex += digits[b & 0xf];
+  }
+  return hex;
+}
+
+// packs a row in the contract's binary layout
+struct packer {
+  std::vector<uint8_t> bytes;
+
+  packer &uint(uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) bytes.push_back(uint8_t(value >> (8 * i)));
+    return *this;
+  }
+
+  packer &varuint32(uint32_t value) {
+    do {
+      uint8_t b = value & 0x7f;
+      value >>= 7;
+      bytes.push_back(value != 0 ? (b | 0x80) : b);
+    } while (value != 0);
+    return *this;
+  }
+
+  packer &asset(int64_t amount, uint64_t symbol) { return uint(uint64_t(amount), 8).uint(symbol, 8); }
+
+  packer &string(const std::string &text) {
+    varuint32(uint32_t(text.size()));
+    bytes.insert(bytes.end(), text.begin(), text.end());
+    return *this;
+  }
+};
+
+// the FREEOS symbol with precision 4
+constexpr uint64_t FREEOS_SYMBOL = 4 | uint64_t('F') << 8 | uint64_t('R') << 16 | uint64_t('E') << 24 |
+  uint64_t('E') << 32 | uint64_t('O') << 40 | uint64_t('S') << 48;
+
+class node {
+public:
+  static constexpr int IDLE_MS = 50;
+
+  struct row {
+    uint64_t secondary = 0;   // the key of index_position 2
+    std::vector<uint8_t> data;
+  };
+
+  // (scope, table) -> primary key -> row
+  std::map<std::pair<uint64_t, std::string>, std::map<uint64_t, row>> tables;
+  std::string payer = "cronacle";
+
+  std::atomic<int> rounds{0};
+  std::atomic<int> requests{0};
+
+  node() {
+    listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    if (listener < 0 || ::bind(listener, (sockaddr *)&address, sizeof(address)) != 0 || ::listen(listener, 4) != 0) {
+      throw std::runtime_error("cannot listen on the loopback interface");
+    }
+    socklen_t length = sizeof(address);
+    ::getsockname(listener, (sockaddr *)&address, &length);
+    port_number = ntohs(address.sin_port);
+  }
+
+  ~node() { stop(); }
+
+  std::string port() const { return std::to_string(port_number); }
+
+  void put(uint64_t scope, const std::string &table, uint64_t key, const std::vector<uint8_t> &data, uint64_t secondary = 0) {
+    std::lock_guard<std::mutex> guard(lock);
+    tables[{scope, table}][key] = row{secondary, data};
+  }
+
+  void erase_scope(uint64_t scope, const std::string &table) {
+    std::lock_guard<std::mutex> guard(lock);
+    tables.erase({scope, table});
+  }
+
+  void start() {
+    serving = true;
+    server = std::thread([this] { serve(); });
+  }
+
+  void stop() {
+    if (!serving) return;
+    serving = false;
+    ::shutdown(listener, SHUT_RDWR);
+    ::close(listener);
+    if (server.joinable()) server.join();
+  }
+
+  void reset_counts() {
+    rounds = 0;
+    requests = 0;
+  }
+
+private:
+  int listener = -1;
+  uint16_t port_number = 0;
+  std::atomic<bool> serving{false};
+  std::thread server;
+  std::mutex lock;
+
+  struct open_connection {
+    int fd;
+    std::string buffer;
+  };
+
+  void serve() {
+    std::vector<open_connection> connections;
+    while (serving) {
+      std::vector<pollfd> waiting = {{listener, POLLIN, 0}};
+      for (const auto &c : connections) waiting.push_back({c.fd, POLLIN, 0});
+
+      if (::poll(waiting.data(), waiting.size(), IDLE_MS) > 0) {
+        if (waiting[0].revents & POLLIN) {
+          int fd = ::accept(listener, nullptr, nullptr);
+          if (fd >= 0) connections.push_back({fd, ""});
+        }
+        for (size_t i = 1; i < waiting.size(); i++) {
+          if (!(waiting[i].revents & (POLLIN | POLLHUP))) continue;
+          char chunk[16384];
+          ssize_t n = ::recv(waiting[i].fd, chunk, sizeof(chunk), 0);
+          if (n <= 0) {
+            ::close(connections[i - 1].fd);
+            connections[i - 1].fd = -1;
+          } else {
+            connections[i - 1].buffer.append(chunk, size_t(n));
+          }
+        }
+        connections.erase(std::remove_if(connections.begin(), connections.end(),
+          [](const open_connection &c) { return c.fd < 0; }), connections.end());
+        continue;
+      }
+
+      // every connection is idle: answer the complete requests of each as one round trip
+      for (auto &c : connections) answer(c);
+    }
+    for (auto &c : connections) ::close(c.fd);
+  }
+
+  void answer(open_connection &c) {
+    std::string responses;
+    int answered = 0;
+    for (;;) {
+      size_t header_end = c.buffer.find("\r\n\r\n");
+      if (header_end == std::string::npos) break;
+      std::string headers = c.buffer.substr(0, header_end);
+      size_t length_at = headers.find("Content-Length:");
+      size_t length = (length_at == std::string::npos) ? 0 : std::stoul(headers.substr(length_at + 15));
+      if (c.buffer.size() < header_end + 4 + length) break;
+
+      std::string path = headers.substr(headers.find(' ') + 1);
+      path = path.substr(0, path.find(' '));
+      std::string body = c.buffer.substr(header_end + 4, length);
+      c.buffer.erase(0, header_end + 4 + length);
+
+      std::string answer = respond(path, body);
+      responses += "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+        std::to_string(answer.size()) + "\r\n\r\n" + answer;
+      answered++;
+    }
+    if (answered == 0) return;
+
+    rounds++;
+    requests += answered;
+    for (size_t sent = 0; sent < responses.size();) {
+      ssize_t n = ::send(c.fd, responses.data() + sent, responses.size() - sent, MSG_NOSIGNAL);
+      if (n <= 0) return;
+      sent += size_t(n);
+    }
+  }
+
+  std::string respond(const std::string &path, const std::string &body) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (path == "/v1/chain/get_table_rows") return table_rows(body);
+    if (path == "/v1/chain/get_table_by_scope") return table_scopes(body);
+    return "{\"rows\":[],\"more\":false}";
+  }
+
+  std::string table_rows(const std::string &body) {
+    auto found = tables.find({scope_value(json_field(body, "scope")), json_field(body, "table")});
+    std::string limit_field = json_field(body, "limit");
+    uint32_t limit = limit_field.empty() ? 10 : uint32_t(std::stoul(limit_field));
+    bool reverse = json_field(body, "reverse") == "true";
+    bool by_secondary = json_field(body, "index_position") == "2";
+    std::string lower_field = json_field(body, "lower_bound");
+    std::string upper_field = json_field(body, "upper_bound");
+    uint64_t lower = lower_field.empty() ? 0 : scope_value(lower_field);
+    uint64_t upper = upper_field.empty() ? UINT64_MAX : scope_value(upper_field);
+
+    // the rows in index order, as (index key, primary key, data)
+    std::vector<std::tuple<uint64_t, uint64_t, const std::vector<uint8_t> *>> ordered;
+    if (found != tables.end()) {
+      for (const auto &entry : found->second) {
+        uint64_t key = by_secondary ? entry.second.secondary : entry.first;
+        if (key >= lower && key <= upper) ordered.emplace_back(key, entry.first, &entry.second.data);
+      }
+    }
+    std::sort(ordered.begin(), ordered.end());
+    if (reverse) std::reverse(ordered.begin(), ordered.end());
+
+    std::string rows;
+    size_t count = std::min<size_t>(limit, ordered.size());
+    for (size_t i = 0; i < count; i++) rows += std::string(i > 0 ? "," : "") + "\"" + to_hex(*std::get<2>(ordered[i])) + "\"";
+
+    bool more = ordered.size() > count;
+    std::string next_key = more ? std::to_string(std::get<0>(ordered[count])) : "";
+    return "{\"rows\":[" + rows + "],\"more\":" + (more ? "true" : "false") + ",\"next_key\":\"" + next_key + "\"}";
+  }
+
+  std::string table_scopes(const std::string &body) {
+    std::string table = json_field(body, "table");
+    std::string lower_field = json_field(body, "lower_bound");
+    std::string limit_field = json_field(body, "limit");
+    uint64_t lower = lower_field.empty() ? 0 : name_value(lower_field);
+    uint32_t limit = limit_field.empty() ? 10 : uint32_t(std::stoul(limit_field));
+
+    std::string rows;
+    uint32_t count = 0;
+    std::string more;
+    for (const auto &entry : tables) {
+      if (entry.first.first < lower || entry.second.empty()) continue;
+      if (!table.empty() && entry.first.second != table) continue;
+      if (count == limit) {
+        more = name_string(entry.first.first);
+        break;
+      }
+      rows += std::string(count > 0 ? "," : "") + "{\"code\":\"" + payer + "\",\"scope\":\"" + name_string(entry.first.first) +
+        "\",\"table\":\"" + entry.first.second + "\",\"payer\":\"" + payer + "\",\"count\":" + std::to_string(entry.second.size()) + "}";
+      count++;
+    }
+    return "{\"rows\":[" + rows + "],\"more\":\"" + more + "\"}";
+  }
+};
+
+} // namespace cronacle_standin
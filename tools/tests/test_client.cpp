@@ -0,0 +1,124 @@
+// Tests of the native table client in cronacle_client.hpp against the stand-in node in standin_node.hpp.
+//
+// Build:  g++ -std=c++17 -O2 -pthread -o test_client tools/tests/test_client.cpp
+// Run:    ./test_client, which prints each failed check and exits with 1 if any failed
+
+#include "standin_node.hpp"
+
+#include <iostream>
+
+using namespace cronacle_client;
+using cronacle_standin::FREEOS_SYMBOL;
+using cronacle_standin::packer;
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { std::cout << "FAIL line " << __LINE__ << ": " #cond << "\n"; failures++; } } while (0)
+
+static const uint64_t CONTRACT = name_value("cronacle");
+
+static std::vector<uint8_t> auction_bytes(uint32_t number, uint64_t winner) {
+  int64_t start = int64_t(number) * 100000000;
+  return packer().uint(number, 4).uint(1000 + number, 8).uint(start, 8).uint(start + 60000000, 8)
+    .uint(start + 99999000, 8).uint(winner, 8).asset(winner != 0 ? number * 10000 : 0, winner != 0 ? FREEOS_SYMBOL : 0).bytes;
+}
+
+// auctions 1 to 5 in the contract's scope, written before seasons, and 4 auctions a season in seasons 1 to
+// seasons. The latest auction, the last of the last season, has no winner yet
+static void put_auctions(cronacle_standin::node &node, uint32_t seasons) {
+  uint32_t number = 1;
+  for (; number <= 5; number++) node.put(CONTRACT, "auctions", number, auction_bytes(number, name_value("alice")));
+  for (uint32_t season = 1; season <= seasons; season++) {
+    for (int i = 0; i < 4; i++, number++) {
+      bool latest = season == seasons && i == 3;
+      node.put(season, "auctions", number, auction_bytes(number, latest ? 0 : name_value("bob")));
+    }
+  }
+  node.put(CONTRACT, "auctionhead", 0, packer().uint(number - 1, 4).uint(seasons, 8).bytes);
+}
+
+static void test_credits() {
+  cronacle_standin::node node;
+  node.put(name_value("alice"), "credits", FREEOS_SYMBOL >> 8, packer().asset(500000, FREEOS_SYMBOL).bytes);
+  node.put(name_value("bob"), "credits", FREEOS_SYMBOL >> 8, packer().asset(12345, FREEOS_SYMBOL).bytes);
+  node.start();
+
+  client c("127.0.0.1", node.port(), "cronacle");
+  auto credits = c.credits({"alice", "bob", "carol"});
+  CHECK(credits["alice"].to_string() == "50.0000 FREEOS");
+  CHECK(credits["bob"].to_string() == "1.2345 FREEOS");
+  CHECK(credits["carol"].amount == 0);
+  CHECK(node.rounds == 1 && node.requests == 3);
+}
+
+static void test_latest_auctions() {
+  cronacle_standin::node node;
+  put_auctions(node, 20);   // auctions 1 to 85, the latest in season 20
+  node.start();
+  client c("127.0.0.1", node.port(), "cronacle");
+
+  // the head, then seasons 20 to 13 in one batch
+  auto latest = c.latest_auctions(10);
+  CHECK(latest.size() == 10 && latest.front().number == 85 && latest.back().number == 76);
+  CHECK(latest.front().winner == 0 && latest.back().winner == name_value("bob"));
+  CHECK(node.rounds == 2);
+
+  // reaching back past the cached auctions into the contract's scope
+  auto all = c.latest_auctions(100);
+  CHECK(all.size() == 85 && all.back().number == 1 && all.back().bidamount.to_string() == "1.0000 FREEOS");
+  bool ordered = true;
+  for (size_t i = 1; i < all.size(); i++) ordered = ordered && all[i].number + 1 == all[i - 1].number;
+  CHECK(ordered);
+
+  // every settled auction is cached: the head, and one batch for the latest auction, which has not been settled
+  node.reset_counts();
+  all = c.latest_auctions(100);
+  CHECK(all.size() == 85 && all.front().number == 85 && all.back().number == 1);
+  CHECK(node.rounds == 2 && node.requests == 2 + 8);
+
+  // without a cache: the head, then the 21 scopes in three batches, where one round trip a scope took 22
+  client fresh("127.0.0.1", node.port(), "cronacle");
+  node.reset_counts();
+  CHECK(fresh.latest_auctions(100).size() == 85);
+  CHECK(node.rounds == 4 && node.requests == 2 + 21);
+}
+
+static void test_auctions_after() {
+  cronacle_standin::node node;
+  put_auctions(node, 12);   // auctions 1 to 53
+  // a season with more auctions than a page holds
+  for (uint32_t number = 54; number <= 300; number++) node.put(13, "auctions", number, auction_bytes(number, name_value("bob")));
+  node.put(CONTRACT, "auctionhead", 0, packer().uint(300, 4).uint(13, 8).bytes);
+  node.start();
+  client c("127.0.0.1", node.port(), "cronacle");
+
+  auto after = c.auctions_after(3);
+  CHECK(after.size() == 297 && after.front().number == 4 && after.back().number == 300);
+  bool ordered = true;
+  for (size_t i = 1; i < after.size(); i++) ordered = ordered && after[i].number == after[i - 1].number + 1;
+  CHECK(ordered);
+  // the head; seasons 13 to 6 and their further pages; seasons 5 to 1 and the contract's scope
+  CHECK(node.rounds == 1 + 3 + 1);
+
+  node.reset_counts();
+  after = c.auctions_after(290);
+  CHECK(after.size() == 10 && after.front().number == 291);
+  CHECK(node.rounds == 2);
+
+  node.reset_counts();
+  CHECK(c.auctions_after(300).empty());
+  CHECK(node.rounds == 1);
+}
+
+int main() {
+  test_credits();
+  test_latest_auctions();
+  test_auctions_after();
+
+  if (failures > 0) {
+    std::cout << failures << " failed\n";
+    return 1;
+  }
+  std::cout << "all passed\n";
+  return 0;
+}
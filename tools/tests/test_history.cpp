@@ -0,0 +1,133 @@
+// Tests of cronacle_history: syncs a store from the stand-in node in standin_node.hpp by running the tool, then
+// checks the store through the tool's queries.
+//
+// Build:  g++ -std=c++17 -O2 -pthread -o test_history tools/tests/test_history.cpp
+// Run:    ./test_history PATH_TO_CRONACLE_HISTORY, which prints each failed check and exits with 1 if any failed
+
+#include "standin_node.hpp"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace cronacle_client;
+using cronacle_standin::FREEOS_SYMBOL;
+using cronacle_standin::packer;
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { std::cout << "FAIL line " << __LINE__ << ": " #cond << "\n"; failures++; } } while (0)
+
+static const uint64_t CONTRACT = name_value("cronacle");
+static const int BID_HISTORY_SLOTS = 16;
+
+static std::string tool;
+static std::string store;
+
+// runs the tool on the store and returns its output
+static std::string run(const std::string &arguments) {
+  std::string output;
+  FILE *p = popen((tool + " " + store + " " + arguments + " 2>&1").c_str(), "r");
+  char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), p)) > 0) output.append(buffer, n);
+  pclose(p);
+  return output;
+}
+
+// an auction that starts at number * 100 seconds; winner 0 for an unsold auction, whose amount has no symbol
+static void put_auction(cronacle_standin::node &node, uint64_t scope, uint32_t number, uint64_t winner, int64_t amount) {
+  int64_t start = int64_t(number) * 100000000;
+  node.put(scope, "auctions", number, packer().uint(number, 4).uint(1000 + number, 8).uint(start, 8)
+    .uint(start + 60000000, 8).uint(start + 99999000, 8).uint(winner, 8).asset(amount, winner != 0 ? FREEOS_SYMBOL : 0).bytes);
+}
+
+// a bid history ring after `bids` bids of 1.0000, 2.0000, ... placed a second apart, with the last by the winner
+static void put_history(cronacle_standin::node &node, uint32_t number, int bids, uint64_t winner) {
+  std::vector<std::tuple<uint64_t, uint64_t, uint32_t>> slots(BID_HISTORY_SLOTS, std::make_tuple(0, 0, 0));
+  for (int i = 0; i < bids; i++) {
+    uint64_t bidder = (i + 1 == bids) ? winner : name_value(i % 2 == 0 ? "carol" : "dave");
+    slots[i % BID_HISTORY_SLOTS] = std::make_tuple(bidder, uint64_t(i + 1) * 10000, uint32_t(i + 1));
+  }
+
+  packer row;
+  row.uint(number, 4).uint(uint64_t(bids % BID_HISTORY_SLOTS), 1).varuint32(BID_HISTORY_SLOTS);
+  for (const auto &slot : slots) row.uint(std::get<0>(slot), 8).uint(std::get<1>(slot), 8).uint(std::get<2>(slot), 4);
+  node.put(CONTRACT, "bidhistory", number, row.bytes);
+}
+
+static std::string meta() {
+  std::string text;
+  FILE *f = std::fopen((store + "/meta").c_str(), "r");
+  char line[128];
+  while (f != nullptr && std::fgets(line, sizeof(line), f) != nullptr) text += line;
+  if (f != nullptr) std::fclose(f);
+  return text;
+}
+
+static bool contains(const std::string &text, const std::string &part) {
+  return text.find(part) != std::string::npos;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    std::cerr << "usage: test_history PATH_TO_CRONACLE_HISTORY\n";
+    return 2;
+  }
+  tool = argv[1];
+  char dir_template[] = "/tmp/cronacle_history_test.XXXXXX";
+  store = mkdtemp(dir_template);
+
+  cronacle_standin::node node;
+  uint64_t alice = name_value("alice"), bob = name_value("bob");
+
+  // auction 1 sold after 3 bids; auction 2 unsold; auction 3, in season 1, sold after 20 bids, of which the ring
+  // keeps the last 16; auction 4 is open
+  put_auction(node, CONTRACT, 1, alice, 30000);
+  put_history(node, 1, 3, alice);
+  put_auction(node, CONTRACT, 2, 0, 0);
+  put_auction(node, 1, 3, bob, 200000);
+  put_history(node, 3, 20, bob);
+  put_auction(node, 1, 4, 0, 0);
+  put_history(node, 4, 1, alice);
+  node.put(CONTRACT, "auctionhead", 0, packer().uint(4, 4).uint(1, 8).bytes);
+  node.start();
+  std::string sync = "sync 127.0.0.1 " + node.port() + " cronacle";
+
+  std::string output = run(sync);
+  CHECK(contains(output, "appended 3 auctions and 19 bids"));
+  CHECK(contains(meta(), "auctions 3\nbids 19\n"));
+  CHECK(contains(run("stats"), "sold 2 total 23.0000 FREEOS"));
+  CHECK(contains(run("bidders 1 --nft 1003"), "carol 8 total 96.0000 FREEOS"));
+  // the ring holds the bids from the fifth on, at the auction's start plus the recorded seconds
+  CHECK(contains(run("stats --nft 1003"), "sold 1"));
+  CHECK(contains(run("bidders 5 --nft 1003 --from 305 --to 306"), "carol 1 total 5.0000 FREEOS"));
+  CHECK(run("bidders 5 --nft 1003 --to 305").empty());
+
+  // nothing new: nothing is appended again
+  CHECK(contains(run(sync), "appended 0 auctions and 0 bids"));
+
+  // auction 4 settles and 5 opens, in season 2
+  put_auction(node, 1, 4, alice, 10000);
+  put_auction(node, 2, 5, 0, 0);
+  node.put(CONTRACT, "auctionhead", 0, packer().uint(5, 4).uint(2, 8).bytes);
+  CHECK(contains(run(sync), "appended 1 auctions and 1 bids"));
+  CHECK(contains(run("winners"), "alice 2 total 4.0000 FREEOS"));
+
+  // records appended from another source skip the auctions already stored
+  FILE *input = popen((tool + " " + store + " append > /dev/null").c_str(), "w");
+  std::fputs("auction 4 1004 400000000 499999000 alice 1.0000 FREEOS\n"
+             "bid 4 400000001 alice 1004 1.0000 FREEOS\n"
+             "auction 5 1005 500000000 599999000 - 0 -\n"
+             "bid 6 600000001 bob 1006 3.0000 FREEOS\n", input);
+  pclose(input);
+  CHECK(contains(meta(), "auctions 5\nbids 21\n"));
+
+  std::system(("rm -r " + store).c_str());
+
+  if (failures > 0) {
+    std::cout << failures << " failed\n";
+    return 1;
+  }
+  std::cout << "all passed\n";
+  return 0;
+}
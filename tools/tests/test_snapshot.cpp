@@ -0,0 +1,198 @@
+// Round-trip test of the snapshot tools: cronacle_export dumps the tables of the stand-in node in
+// standin_node.hpp, cronacle_snapshot packs the dump into importstate chunks, the contract's importstate action
+// loads the chunks on the native host in tools/native, and the tables it writes, put into a second stand-in node,
+// must export to the same dump and hold the same stored rows.
+//
+// Build:  g++ -std=c++17 -O2 -pthread -Wno-attributes -Itools/native -o test_snapshot tools/tests/test_snapshot.cpp
+// Run:    ./test_snapshot PATH_TO_CRONACLE_EXPORT PATH_TO_CRONACLE_SNAPSHOT, which prints each failed check and
+//         exits with 1 if any failed
+
+#include "../../cronacle.cpp"
+
+#include "standin_node.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+using cronacle_client::from_hex;
+using cronacle_client::name_value;
+using cronacle_standin::FREEOS_SYMBOL;
+using cronacle_standin::packer;
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { std::cout << "FAIL line " << __LINE__ << ": " #cond << "\n"; failures++; } } while (0)
+
+static const uint64_t CONTRACT = name_value("cronacle");
+static const uint64_t POINT_SYMBOL = 0 | uint64_t('P') << 8 | uint64_t('O') << 16 | uint64_t('I') << 24 |
+  uint64_t('N') << 32 | uint64_t('T') << 40;
+
+// runs a command, with the input on its standard input, and returns its standard output
+static std::string run(const std::string &command, const std::string &input) {
+  std::string input_path = "/tmp/cronacle_snapshot_test.in";
+  FILE *f = std::fopen(input_path.c_str(), "w");
+  std::fputs(input.c_str(), f);
+  std::fclose(f);
+
+  std::string output;
+  FILE *p = popen((command + " < " + input_path).c_str(), "r");
+  char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), p)) > 0) output.append(buffer, n);
+  if (pclose(p) != 0) output += "(exit status)";
+  std::remove(input_path.c_str());
+  return output;
+}
+
+static std::vector<uint8_t> auction_bytes(uint32_t number, uint64_t winner, int64_t amount) {
+  int64_t start = int64_t(number) * 100000000;
+  return packer().uint(number, 4).uint(1000 + number, 8).uint(start, 8).uint(start + 60000000, 8)
+    .uint(start + 99999000, 8).uint(winner, 8).asset(amount, winner != 0 ? FREEOS_SYMBOL : 0).bytes;
+}
+
+// the state of a contract with seasons, a bundle, an unsold auction and a custodian, as the contract stores it
+static void put_state(cronacle_standin::node &node) {
+  uint64_t alice = name_value("alice"), bob = name_value("bob"), carol = name_value("carol");
+
+  node.put(CONTRACT, "parameters", name_value("currency"), packer().uint(name_value("currency"), 8).string("4 FREEOS freeostokens").bytes);
+  node.put(CONTRACT, "parameters", name_value("seasonlen"), packer().uint(name_value("seasonlen"), 8).string("86400").bytes);
+  node.put(CONTRACT, "admins", bob, packer().uint(bob, 8).bytes);
+  node.put(CONTRACT, "system", 0, packer().uint(1000000000, 8).uint(3, 4).asset(1000000, POINT_SYMBOL).bytes);
+
+  node.put(alice, "users", alice, packer().uint(1100000000, 8).uint(alice, 8).string("aaaaa-bb").bytes);
+  node.put(bob, "users", bob, packer().uint(1200000000, 8).uint(bob, 8).string("").bytes);
+  node.put(alice, "credits", 0, packer().asset(500000, FREEOS_SYMBOL).bytes);
+  node.put(carol, "credits", 0, packer().asset(150000, FREEOS_SYMBOL).bytes);
+
+  node.put(CONTRACT, "custodians", carol, packer().uint(carol, 8).asset(100000, FREEOS_SYMBOL).uint(7, 8).uint(1006, 8)
+    .asset(20000, FREEOS_SYMBOL).bytes);
+  node.put(carol, "subaccounts", 7, packer().uint(7, 8).asset(60000, FREEOS_SYMBOL).bytes);
+  node.put(carol, "subaccounts", 8, packer().uint(8, 8).asset(40000, FREEOS_SYMBOL).bytes);
+
+  // an entry without a bundle leaves the binary extension out, as addnft stores it
+  node.put(CONTRACT, "nfts", 1, packer().uint(1, 4).uint(1006, 8).bytes, 1006);
+  node.put(CONTRACT, "nfts", 2, packer().uint(2, 4).uint(1007, 8).varuint32(2).uint(1008, 8).uint(1009, 8).bytes, 1007);
+
+  // auctions 1 and 2 before seasons, 3 and 4 in season 1, 5 and 6 in season 2; 4 ended unsold and 6 is open
+  node.put(CONTRACT, "auctions", 1, auction_bytes(1, alice, 30000));
+  node.put(CONTRACT, "auctions", 2, auction_bytes(2, bob, 40000));
+  node.put(1, "auctions", 3, auction_bytes(3, alice, 50000));
+  node.put(1, "auctions", 4, auction_bytes(4, 0, 0));
+  node.put(2, "auctions", 5, auction_bytes(5, bob, 60000));
+  node.put(2, "auctions", 6, auction_bytes(6, 0, 0));
+  node.put(CONTRACT, "auctionhead", 0, packer().uint(6, 4).uint(2, 8).bytes);
+}
+
+const name SELF = "cronacle"_n;
+
+// loads one chunk with the contract's importstate action, run on the native host as the contract
+static void import_chunk(const std::string &table, const std::string &hex) {
+  std::vector<uint8_t> bytes = from_hex(hex);
+  native::host_state &host = native::host();
+  host.begin_action({SELF});
+  try {
+    cronacle contract(SELF, SELF, datastream<const char *>(nullptr, 0));
+    contract.importstate(name(table), std::vector<char>(bytes.begin(), bytes.end()));
+    host.commit();
+  } catch (const check_failure &e) {
+    host.revert();
+    std::cout << "importstate " << table << " failed: " << e.what() << "\n";
+    failures++;
+  }
+}
+
+// puts the host's rows of the tables that the source node holds into the node, with the key of their first
+// secondary index, which the nfts table is read by
+static void put_imported(const cronacle_standin::node &source, cronacle_standin::node &node) {
+  native::host_state &host = native::host();
+  for (const auto &entry : host.tables) {
+    auto [code, scope, table] = entry.first;
+    std::string table_name = name(table).to_string();
+    bool exported = std::any_of(source.tables.begin(), source.tables.end(),
+      [&](const auto &t) { return t.first.second == table_name; });
+    if (code != SELF.value || !exported) continue;
+
+    native::table_id first_index = {code, scope, (table & 0xFFFFFFFFFFFFFFF0ULL) | 0};
+    for (const auto &row : entry.second.rows) {
+      std::vector<char> data = row.second.packed(row.second.object);
+      node.put(scope, table_name, row.first, std::vector<uint8_t>(data.begin(), data.end()),
+        host.secondary_of(first_index, row.first).value_or(0));
+    }
+  }
+}
+
+static bool contains(const std::string &text, const std::string &part) {
+  return text.find(part) != std::string::npos;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::cerr << "usage: test_snapshot PATH_TO_CRONACLE_EXPORT PATH_TO_CRONACLE_SNAPSHOT\n";
+    return 2;
+  }
+  std::string exporter = argv[1], packer_tool = argv[2];
+
+  cronacle_standin::node source;
+  put_state(source);
+  source.start();
+  std::string dump = run(exporter + " 127.0.0.1 " + source.port() + " cronacle", "");
+
+  CHECK(contains(dump, "parameters currency 4 FREEOS freeostokens\n"));
+  CHECK(contains(dump, "system 1000000000 3 1000000 POINT\n"));
+  CHECK(contains(dump, "users alice 1100000000 aaaaa-bb\n"));
+  CHECK(contains(dump, "users bob 1200000000\n"));
+  CHECK(contains(dump, "credits carol 15.0000 FREEOS\n"));
+  CHECK(contains(dump, "custodians carol 10.0000 FREEOS 7 1006 2.0000 FREEOS\n"));
+  CHECK(contains(dump, "subaccounts carol 8 4.0000 FREEOS\n"));
+  CHECK(contains(dump, "nfts 2 1007 1008 1009\n"));
+  CHECK(contains(dump, "auctionhead 6 2\n"));
+  CHECK(contains(dump, "auctions - 2 1002 200000000 260000000 299999000 bob 4.0000 FREEOS\n"));
+  CHECK(contains(dump, "auctions 1 4 1004 400000000 460000000 499999000 - 0 -\n"));
+
+  std::string chunks = run(packer_tool + " -n 2", dump);
+  CHECK(!contains(chunks, "(exit status)"));
+
+  // imported after the rows' times, so that an activity record dated by the import would show
+  native::host().reset();
+  native::host().now_us = int64_t(2000000000) * 1000000;
+  std::istringstream lines(chunks);
+  std::string table, hex;
+  while (lines >> table >> hex) import_chunk(table, hex);
+
+  // the rows importstate derives from the users table
+  {
+    activity_index activity_table(SELF, SELF.value);
+    auto alice_activity = activity_table.find("alice"_n.value);
+    CHECK(alice_activity != activity_table.end() && alice_activity->last == time_point(microseconds(1100000000)));
+    CHECK(activity_table.find("bob"_n.value) != activity_table.end());
+    principals_index principals_table(SELF, SELF.value);
+    auto alice_link = principals_table.find("alice"_n.value);
+    CHECK(alice_link != principals_table.end() && alice_link->principal == "aaaaa-bb");
+    CHECK(principals_table.find("bob"_n.value) == principals_table.end());
+  }
+
+  cronacle_standin::node target;
+  put_imported(source, target);
+  target.start();
+
+  CHECK(run(exporter + " 127.0.0.1 " + target.port() + " cronacle", "") == dump);
+  CHECK(target.tables.size() == source.tables.size());
+  for (const auto &entry : source.tables) {
+    auto loaded = target.tables.find(entry.first);
+    bool same = loaded != target.tables.end() && loaded->second.size() == entry.second.size();
+    for (auto row = entry.second.begin(); same && row != entry.second.end(); row++) {
+      auto other = loaded->second.find(row->first);
+      same = other != loaded->second.end() && other->second.data == row->second.data;
+    }
+    if (!same) std::cout << "table " << entry.first.second << " scope " << entry.first.first << " differs\n";
+    CHECK(same);
+  }
+
+  if (failures > 0) {
+    std::cout << failures << " failed\n";
+    return 1;
+  }
+  std::cout << "all passed\n";
+  return 0;
+}